@@ -0,0 +1,2880 @@
+#include "kaleidoscope.h"
+
+#include <stdlib.h>
+#include <string.h>  // for memset
+#include <math.h>    // for sqrtf, sinf
+// CMSIS intrinsics on Cortex-M only: compilers for ARM Linux hosts (armhf)
+// define __ARM_FEATURE_DSP as well, but have no CMSIS
+#if defined(__ARM_ARCH_7EM__) || (defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M')
+#include <cmsis_compiler.h> // DSP intrinsics and __RBIT on the device
+#ifdef __ARM_FEATURE_DSP
+#define DSP_INTRINSICS
+#endif
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h> // movemask packing when built for a host
+#endif
+
+#define COUNT_OF(x) (sizeof(x) / sizeof((x)[0]))
+
+// Screen dimensions
+#define W KAL_WIDTH
+#define H KAL_HEIGHT
+
+// Density of the current run (0–100)
+static uint8_t dot_threshold = 50;
+
+// Styles, in the order Left/Right cycles through them:
+// 0 = old-style2  (rotated-line “star” → originally Vis 3)
+// 1 = old-style1  (concentric-arcs → originally Vis 2, unchanged)
+// 2 = old-style3  (quadrant-noise → originally Vis 4)
+// 3 = old-style0  (random mirrored dots → originally Vis 1)
+// 4.. = the styles added since, in order
+static uint8_t style = 0xFF;
+
+#define STYLE_COUNT KAL_STYLE_COUNT
+
+// Styles that render any frame from its number alone, so kal_seek can jump
+// straight to it: everything but the simulations (turmites, boids, maze,
+// ripple tank and reaction-diffusion), which have to replay their run. A
+// seek sets style_reset, after which these styles redraw from scratch.
+#define SEEKABLE_STYLES \
+    ((1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 9) | \
+     (1 << 13) | (1 << 14) | (1 << 15) | (1 << 16) | (1 << 17))
+
+static bool style_seekable(uint8_t s) {
+    return s < STYLE_COUNT && ((SEEKABLE_STYLES >> s) & 1);
+}
+
+// Frame counter for animation
+static uint32_t frame = 0;
+
+// Set on the first frame of a run, so that stateful styles know to re-seed
+// their simulation
+static bool style_reset = true;
+
+// Set by kal_poke; interactive styles consume it, the rest ignore it
+static bool poke_pending = false;
+
+// Seed of the current run, and whether the run still follows from it alone
+static uint32_t run_seed = 0;
+static bool run_pristine = false;
+
+static KalBudgetCallback budget_callback = NULL;
+static void* budget_ctx = NULL;
+
+static KalYieldCallback yield_callback = NULL;
+static void* yield_ctx = NULL;
+
+// Clamp helper
+static uint8_t clamp_u8(uint8_t v, uint8_t lo, uint8_t hi) {
+    if(v < lo) return lo;
+    if(v > hi) return hi;
+    return v;
+}
+
+//--------------------------------------------------------------------------------
+// Random numbers: xorshift32, so that a run depends only on its seed and not
+// on the C library or whoever else calls rand()
+//--------------------------------------------------------------------------------
+static uint32_t rng_state = 1;
+
+static void rng_seed(uint32_t seed) {
+    rng_state = seed * 2654435761UL + 0x9E3779B9UL;
+    if(!rng_state) rng_state = 1;
+}
+
+// Uniform in 0 .. 0x7FFFFFFF, like rand()
+static int32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return (int32_t)(x >> 1);
+}
+
+// Stateless hash of the run seed and two values, for styles that render a
+// frame from its number alone rather than from the frames before it
+static uint32_t run_hash(uint32_t a, uint32_t b) {
+    uint32_t h = run_seed ^ (a * 0x9E3779B1UL) ^ (b * 0x85EBCA77UL);
+    h ^= h >> 16;
+    h *= 0x7FEB352DUL;
+    h ^= h >> 15;
+    h *= 0x846CA68BUL;
+    h ^= h >> 16;
+    return h;
+}
+
+// Whether a time-budgeted style may run another iteration this frame. Without
+// a callback one iteration is assumed to take a millisecond.
+static bool budget_left(uint32_t budget_us, uint8_t iterations) {
+    if(budget_callback) return budget_callback(budget_us, iterations, budget_ctx);
+    return iterations * 1000UL < budget_us;
+}
+
+//--------------------------------------------------------------------------------
+// Resumable rendering
+//
+// The heavy styles are written as protothreads, so that kal_render_slice can
+// stop them after any row (or simulation step) and resume them there on the
+// next call. SLICE_BEGIN opens a switch on the line of the last yield;
+// SLICE_YIELD stores its own line and returns false when the yield callback
+// asks for it, and is also the case label the next call jumps back to.
+// Locals do not survive a yield: loop counters live in slice_row, and
+// anything else is recomputed from the frame number on every entry.
+// Resumable styles return true once their frame is done; the others always
+// render a whole frame at once, which is cheap enough for them.
+//--------------------------------------------------------------------------------
+static uint16_t slice_line = 0; // 0 = start of the style's frame
+static int16_t slice_row;
+static bool slice_active = false; // a frame is half done
+static bool slice_may_yield = false; // false when a whole frame is wanted
+
+static bool slice_should_yield(void) {
+    return slice_may_yield && yield_callback && yield_callback(yield_ctx);
+}
+
+#define SLICE_BEGIN() \
+    switch(slice_line) { \
+    case 0:
+
+#define SLICE_YIELD() \
+    do { \
+        if(slice_should_yield()) { \
+            slice_line = __LINE__; \
+            return false; \
+        } \
+        __attribute__((fallthrough)); \
+    case __LINE__:; \
+    } while(0)
+
+#define SLICE_END() \
+    } \
+    slice_line = 0; \
+    return true
+
+//--------------------------------------------------------------------------------
+// Arena: every engine buffer comes out of the one block handed to kal_init
+//
+// The buffers all styles share (framebuffer, filter chain) are carved first
+// and stay. Each run then bump-allocates its style's buffers behind them,
+// and the next kal_start drops those again, so the engine needs the shared
+// part plus its hungriest style rather than the sum of all styles.
+// Allocations are zeroed, so buffers start out like statics would.
+//
+// With no block (arena_base NULL) allocations only advance the offsets,
+// which is how kal_arena_size measures the worst case.
+//--------------------------------------------------------------------------------
+#define ARENA_ALIGN 8
+
+static uint8_t* arena_base = NULL;
+static size_t arena_used = 0;
+static size_t arena_shared = 0; // end of the buffers shared by all styles
+static size_t arena_peak = 0;
+
+static void* arena_alloc(size_t n) {
+    size_t at = (arena_used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    arena_used = at + n;
+    if(arena_used > arena_peak) arena_peak = arena_used;
+    if(!arena_base) return NULL;
+    memset(arena_base + at, 0, n);
+    return arena_base + at;
+}
+
+// Point ptr at count fresh elements of its type
+#define ARENA_NEW(ptr, count) ((ptr) = arena_alloc(sizeof(*(ptr)) * (count)))
+
+//--------------------------------------------------------------------------------
+// Table cache
+//
+// Precomputed tables live in a region of the arena with a fixed byte budget,
+// keyed by (style, density, parameter hash), so that a style can keep one
+// table per density or share one with other styles (style CACHE_SHARED). A
+// miss builds the table in place, first fit; when no gap is big enough the
+// least recently used tables go. Tables used during the current frame are
+// never evicted and tables never move, so a style may hold several at once.
+// Fetch the biggest first: the budget has to leave room for the others even
+// when it sits in the middle of the region.
+// With a table store set, a miss first asks it for a copy saved earlier
+// (typically on an earlier launch), and hands it every table it had to build.
+//--------------------------------------------------------------------------------
+#define CACHE_BUDGET KAL_CACHE_BUDGET
+#define CACHE_SLOTS 16
+#define CACHE_SHARED 0xFF // style of tables shared between styles
+
+typedef struct {
+    uint32_t hash;
+    uint32_t last_use; // cache_clock of the last frame that used it
+    uint16_t offset;
+    uint16_t size; // 0 for a free slot
+    uint8_t style;
+    uint8_t density;
+} CacheEntry;
+
+typedef void (*CacheFill)(void* table);
+
+static uint8_t* cache_base;
+static CacheEntry* cache_entries; // [CACHE_SLOTS]
+static uint32_t cache_clock = 1; // advanced every frame
+static KalCacheStats cache_stats;
+
+static KalTableLoad table_load = NULL;
+static KalTableSave table_save = NULL;
+static void* table_ctx = NULL;
+
+// Lowest offset with size free bytes between the live tables, or -1
+static int32_t cache_find_gap(uint16_t size) {
+    uint32_t at = 0;
+    bool moved = true;
+    while(moved) {
+        moved = false;
+        for(uint8_t i = 0; i < CACHE_SLOTS; i++) {
+            const CacheEntry* e = &cache_entries[i];
+            if(e->size && e->offset < at + size && e->offset + e->size > at) {
+                at = e->offset + e->size;
+                moved = true;
+            }
+        }
+    }
+    return (at + size <= CACHE_BUDGET) ? (int32_t)at : -1;
+}
+
+static void cache_evict(CacheEntry* e) {
+    cache_stats.used -= e->size;
+    cache_stats.tables--;
+    cache_stats.evictions++;
+    e->size = 0;
+}
+
+// The table for (style, density, hash), built by fill on a miss. NULL only
+// if it cannot fit next to the tables already used this frame.
+static void* cache_get(uint8_t style, uint8_t density, uint32_t hash, uint16_t size, CacheFill fill) {
+    CacheEntry* slot = NULL;
+    for(uint8_t i = 0; i < CACHE_SLOTS; i++) {
+        CacheEntry* e = &cache_entries[i];
+        if(!e->size) {
+            if(!slot) slot = e;
+        } else if(e->style == style && e->density == density && e->hash == hash) {
+            // Resumed slices look their tables up again; a hit is one frame's use
+            if(e->last_use != cache_clock) cache_stats.hits++;
+            e->last_use = cache_clock;
+            return cache_base + e->offset;
+        }
+    }
+    cache_stats.misses++;
+
+    int32_t at = -1;
+    while(!slot || (at = cache_find_gap(size)) < 0) {
+        CacheEntry* lru = NULL;
+        for(uint8_t i = 0; i < CACHE_SLOTS; i++) {
+            CacheEntry* e = &cache_entries[i];
+            if(e->size && e->last_use != cache_clock && (!lru || e->last_use < lru->last_use)) lru = e;
+        }
+        if(!lru) return NULL;
+        cache_evict(lru);
+        if(!slot) slot = lru;
+    }
+
+    *slot = (CacheEntry){hash, cache_clock, (uint16_t)at, size, style, density};
+    cache_stats.used += size;
+    cache_stats.tables++;
+
+    void* table = cache_base + at;
+    KalTableKey key = {hash, size, style, density};
+    if(table_load && table_load(&key, table, table_ctx)) {
+        cache_stats.loads++;
+    } else {
+        fill(table);
+        if(table_save) table_save(&key, table, table_ctx);
+    }
+    return table;
+}
+
+//--------------------------------------------------------------------------------
+// Packed 1bpp framebuffer, laid out the way canvas_draw_xbm expects:
+// FB_STRIDE bytes per row, leftmost pixel in the least significant bit
+//--------------------------------------------------------------------------------
+#define FB_STRIDE (W / 8)
+#define FB_BYTES (FB_STRIDE * H)
+static uint8_t* fb;
+
+// The last complete frame, which is what callers see while the next one is
+// still being rendered in slices
+static uint8_t* fb_front;
+
+static inline void fb_clear(void) {
+    memset(fb, 0, FB_BYTES);
+}
+
+static inline bool fb_get(uint8_t x, uint8_t y) {
+    return (fb[y * FB_STRIDE + (x >> 3)] >> (x & 7)) & 1;
+}
+
+static inline void fb_set(uint8_t x, uint8_t y) {
+    fb[y * FB_STRIDE + (x >> 3)] |= (uint8_t)(1 << (x & 7));
+}
+
+static inline void fb_reset(uint8_t x, uint8_t y) {
+    fb[y * FB_STRIDE + (x >> 3)] &= (uint8_t)~(1 << (x & 7));
+}
+
+static inline void fb_flip(uint8_t x, uint8_t y) {
+    fb[y * FB_STRIDE + (x >> 3)] ^= (uint8_t)(1 << (x & 7));
+}
+
+// 4x4 ordered-dither thresholds
+static const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+// 8-bit reversal, for mirroring a packed row
+static inline uint8_t rev8(uint8_t b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+// Set a pixel given in screen coordinates, ignoring anything off screen
+static inline void fb_plot(int x, int y) {
+    if(x < 0 || y < 0 || x >= W || y >= H) return;
+    fb_set(x, y);
+}
+
+//--------------------------------------------------------------------------------
+// Pixel packing: one byte per pixel → packed 1bpp rows
+//
+// Styles that compute a byte per pixel build a row of bytes and pack it in
+// one go. Four 0/1 bytes in a word become four bits with one multiply: the
+// magic constant moves byte i to bit 24 + i (LSB first) or 27 - i (MSB
+// first) and every partial product lands on its own bit, so nothing
+// carries. The threshold variant fuses ordered dithering into the packing:
+// on the Cortex-M4, USUB8 compares four bytes at once and SEL turns its GE
+// flags into 0/1 bytes; elsewhere a carry-free SWAR compare does the same.
+// With SSE2 (host builds) a 16-byte compare and movemask yield 16 bits.
+//--------------------------------------------------------------------------------
+#define PACK_MAGIC_LSB 0x01020408UL
+#define PACK_MAGIC_MSB 0x08040201UL
+
+// Ordered-dither thresholds for pack_threshold_row, bayer4 tiled across a
+// row plus one, so that a value of 0 never lights a pixel
+static uint8_t (*dither_rows)[W]; // [4]
+
+static inline uint32_t pack_load4(const uint8_t* p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// 0x01 for every nonzero byte, 0x00 for every zero byte
+static inline uint32_t pack_nonzero4(uint32_t w) {
+    return (((((w & 0x7F7F7F7FUL) + 0x7F7F7F7FUL) | w) >> 7) & 0x01010101UL);
+}
+
+// 0x01 for every byte where v >= t (unsigned), 0x00 elsewhere
+static inline uint32_t pack_ge4(uint32_t v, uint32_t t) {
+#ifdef DSP_INTRINSICS
+    __USUB8(v, t); // sets GE[i] where v[i] >= t[i]
+    return __SEL(0x01010101UL, 0);
+#else
+    // low 7 bits compared via a borrow-free subtract, top bits fixed up after
+    uint32_t low_ge = (v | 0x80808080UL) - (t & 0x7F7F7F7FUL);
+    return (((v & ~t) | (~(v ^ t) & low_ge)) >> 7) & 0x01010101UL;
+#endif
+}
+
+static inline uint8_t pack_byte(uint32_t lo, uint32_t hi, KalPackOrder order) {
+    if(order == KalPackLsbFirst) {
+        return (((lo * PACK_MAGIC_LSB) >> 24) & 0x0F) | (((hi * PACK_MAGIC_LSB) >> 20) & 0xF0);
+    }
+    return (((lo * PACK_MAGIC_MSB) >> 20) & 0xF0) | (((hi * PACK_MAGIC_MSB) >> 24) & 0x0F);
+}
+
+#ifdef __SSE2__
+static inline void pack_store16(uint8_t* out, uint32_t bits, KalPackOrder order) {
+    out[0] = (order == KalPackLsbFirst) ? (uint8_t)bits : rev8(bits);
+    out[1] = (order == KalPackLsbFirst) ? (uint8_t)(bits >> 8) : rev8(bits >> 8);
+}
+#endif
+
+// Pack n pixels (a multiple of 8) of zero / nonzero bytes into n / 8 bytes
+static void pack_mask_row(const uint8_t* mask, uint8_t* out, uint16_t n, KalPackOrder order) {
+    uint16_t i = 0;
+#ifdef __SSE2__
+    for(; i + 16 <= n; i += 16, out += 2) {
+        __m128i zero = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(mask + i)), _mm_setzero_si128());
+        pack_store16(out, ~_mm_movemask_epi8(zero) & 0xFFFF, order);
+    }
+#endif
+    for(; i < n; i += 8) {
+        *out++ = pack_byte(pack_nonzero4(pack_load4(mask + i)), pack_nonzero4(pack_load4(mask + i + 4)), order);
+    }
+}
+
+// Pack (value[i] >= threshold[i]) for n pixels (a multiple of 8)
+static void pack_threshold_row(
+    const uint8_t* value,
+    const uint8_t* threshold,
+    uint8_t* out,
+    uint16_t n,
+    KalPackOrder order) {
+    uint16_t i = 0;
+#ifdef __SSE2__
+    for(; i + 16 <= n; i += 16, out += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(value + i));
+        __m128i t = _mm_loadu_si128((const __m128i*)(threshold + i));
+        __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, t), v);
+        pack_store16(out, _mm_movemask_epi8(ge), order);
+    }
+#endif
+    for(; i < n; i += 8) {
+        uint32_t lo = pack_ge4(pack_load4(value + i), pack_load4(threshold + i));
+        uint32_t hi = pack_ge4(pack_load4(value + i + 4), pack_load4(threshold + i + 4));
+        *out++ = pack_byte(lo, hi, order);
+    }
+}
+
+static void dither_rows_init(void) {
+    for(uint8_t y = 0; y < 4; y++) {
+        for(uint8_t x = 0; x < W; x++) {
+            dither_rows[y][x] = bayer4[y][x & 3] + 1;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// OLD-STYLE0 → is now at index 3: Random mirrored dots (static until arrow redraw)
+//--------------------------------------------------------------------------------
+static bool render_style0(void) {
+    SLICE_BEGIN();
+    rng_seed(run_hash(frame, 0)); // a fresh stream every frame keeps it seekable
+    fb_clear();
+    for(slice_row = 0; slice_row < W/2; slice_row++) {
+        uint8_t x = slice_row;
+        for(uint8_t y = 0; y < H; y++) {
+            if((rng_next() % 100) < dot_threshold) {
+                fb_plot(x, y);
+                fb_plot(W - 1 - x, y);
+            }
+        }
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// OLD-STYLE1 → is still at index 1: Animated concentric-arc segments
+//--------------------------------------------------------------------------------
+static void render_style1(void) {
+    fb_clear();
+    int cx = W/2;
+    int cy = H/2;
+    uint8_t step = clamp_u8(dot_threshold / 10 + 2, 2, 10);
+    int offset = frame % step;
+    for(int r = offset; r < cy; r += step) {
+        for(int dy = -r; dy <= r; dy++) {
+            int inside = (r * r) - (dy * dy);
+            if(inside < 0) continue;
+            float xf = sqrtf((float)inside);
+            int dx = (int)(xf + 0.5f);
+            fb_plot(cx - dx, cy + dy);
+            fb_plot(cx + dx, cy + dy);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// OLD-STYLE2 → is now at index 0: Animated rotated-line “star” pattern
+//--------------------------------------------------------------------------------
+static void render_style2(void) {
+    fb_clear();
+    int cx = W/2;
+    int cy = H/2;
+    uint8_t spokes = clamp_u8(dot_threshold / 10 + 2, 2, 16);
+    float base_angle = (frame * 0.05f);
+    float angle_step = 3.14159f / spokes;
+    for(uint8_t s = 0; s < spokes; s++) {
+        float angle = base_angle + (s * angle_step);
+        for(int len = 0; len < (W/2); len++) {
+            int x_off = (int)(cosf(angle) * len);
+            int y_off = (int)(sinf(angle) * len);
+            fb_plot(cx + x_off, cy + y_off);
+            fb_plot(cx - x_off, cy + y_off);
+        }
+        float perp = angle + 3.14159f / 2.0f;
+        for(int len = 0; len < (H/2); len++) {
+            int x_off = (int)(cosf(perp) * len);
+            int y_off = (int)(sinf(perp) * len);
+            fb_plot(cx + x_off, cy + y_off);
+            fb_plot(cx - x_off, cy + y_off);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// OLD-STYLE3 → is now at index 2: Drifting gradient noise (coherent smoke)
+//
+// Three octaves of fixed-point value noise, each drifting in its own
+// direction, weighted towards the centre and mirrored 4 ways. No octave is
+// evaluated per pixel: the 16px octave is sampled every 8px, the 8px one
+// every 4px and the 4px one every 2px, then everything is bilinearly
+// upsampled. The two slow octaves only move a fraction of a pixel per frame,
+// so their samples are cached and refreshed every 4th and 2nd frame.
+//--------------------------------------------------------------------------------
+#define NOISE_QW (W / 2)
+#define NOISE_QH (H / 2)
+#define NOISE_OCTAVES 3
+
+typedef struct {
+    uint8_t lattice_shift; // log2 of the lattice spacing in pixels
+    uint8_t sample_shift; // log2 of the sample spacing in pixels
+    uint8_t refresh_mask; // refreshed on frames where (frame & mask) == 0
+    int8_t drift_x; // drift in 1/256 px per frame
+    int8_t drift_y;
+} NoiseOctave;
+
+static const NoiseOctave noise_octaves[NOISE_OCTAVES] = {
+    {4, 3, 3, 77, 26},
+    {3, 2, 1, -128, 51},
+    {2, 1, 0, 127, -102},
+};
+
+#define NOISE_SAMPLES_W(o) ((NOISE_QW >> noise_octaves[o].sample_shift) + 1)
+#define NOISE_SAMPLES_H(o) ((NOISE_QH >> noise_octaves[o].sample_shift) + 1)
+
+#define NOISE_GRID_W ((NOISE_QW >> 1) + 1)
+#define NOISE_GRID_H ((NOISE_QH >> 1) + 1)
+
+// Samples of every octave, on grids of 9x5, 17x9 and 33x17
+static uint8_t (*noise_samples)[NOISE_GRID_H][NOISE_GRID_W]; // [NOISE_OCTAVES]
+// Weighted octave sum on the finest (2px) grid
+static uint16_t (*noise_sum)[NOISE_GRID_W]; // [NOISE_GRID_H]
+
+static void noise_alloc(void) {
+    ARENA_NEW(noise_samples, NOISE_OCTAVES);
+    ARENA_NEW(noise_sum, NOISE_GRID_H);
+}
+
+static inline uint8_t noise_hash(int32_t x, int32_t y) {
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return h >> 24;
+}
+
+// Smoothstep of a Q8 fraction, 3f^2 - 2f^3
+static inline uint32_t noise_fade(uint32_t f) {
+    return (f * f * (3 * 256 - 2 * f)) >> 16;
+}
+
+static inline uint8_t noise_lerp(uint8_t a, uint8_t b, uint32_t t) {
+    return a + (((int32_t)(b - a) * (int32_t)t) >> 8);
+}
+
+// Value noise at a Q8 lattice position
+static uint8_t noise_value(int32_t x, int32_t y) {
+    int32_t ix = x >> 8;
+    int32_t iy = y >> 8;
+    uint32_t fx = noise_fade(x & 0xFF);
+    uint32_t fy = noise_fade(y & 0xFF);
+    uint8_t top = noise_lerp(noise_hash(ix, iy), noise_hash(ix + 1, iy), fx);
+    uint8_t bottom = noise_lerp(noise_hash(ix, iy + 1), noise_hash(ix + 1, iy + 1), fx);
+    return noise_lerp(top, bottom, fy);
+}
+
+// Sample an octave as of its last refresh, so that a seek (which refreshes
+// all of them) gets the same samples as playback
+static void noise_sample_octave(uint8_t o) {
+    const NoiseOctave* oct = &noise_octaves[o];
+    int32_t t = frame & ~(uint32_t)oct->refresh_mask;
+    int32_t ox = t * oct->drift_x;
+    int32_t oy = t * oct->drift_y;
+    for(uint8_t j = 0; j < NOISE_SAMPLES_H(o); j++) {
+        int32_t y = (((int32_t)j << oct->sample_shift) * 256 + oy) >> oct->lattice_shift;
+        for(uint8_t i = 0; i < NOISE_SAMPLES_W(o); i++) {
+            int32_t x = (((int32_t)i << oct->sample_shift) * 256 + ox) >> oct->lattice_shift;
+            noise_samples[o][j][i] = noise_value(x, y);
+        }
+    }
+}
+
+// Bilinearly upsample an octave onto the 2px grid and add it to the sum
+static void noise_accumulate(uint8_t o, uint8_t weight) {
+    uint8_t shift = noise_octaves[o].sample_shift - 1;
+    uint8_t mask = (1 << shift) - 1;
+    for(uint8_t j = 0; j < NOISE_SAMPLES_H(NOISE_OCTAVES - 1); j++) {
+        const uint8_t* r0 = noise_samples[o][j >> shift];
+        const uint8_t* r1 = (j & mask) ? noise_samples[o][(j >> shift) + 1] : r0;
+        uint32_t fy = ((j & mask) << 8) >> shift;
+        for(uint8_t i = 0; i < NOISE_SAMPLES_W(NOISE_OCTAVES - 1); i++) {
+            uint8_t ci = i >> shift;
+            uint32_t fx = ((i & mask) << 8) >> shift;
+            uint8_t top = fx ? noise_lerp(r0[ci], r0[ci + 1], fx) : r0[ci];
+            uint8_t bottom = fx ? noise_lerp(r1[ci], r1[ci + 1], fx) : r1[ci];
+            noise_sum[j][i] += noise_lerp(top, bottom, fy) * weight;
+        }
+    }
+}
+
+static bool render_style3(void) {
+    SLICE_BEGIN();
+    for(slice_row = 0; slice_row < NOISE_OCTAVES; slice_row++) {
+        uint8_t o = slice_row;
+        if(style_reset || (frame & noise_octaves[o].refresh_mask) == 0) noise_sample_octave(o);
+        SLICE_YIELD();
+    }
+
+    // Octave weights 4:2:2 of 8, so the sum stays within 0..255 * 8
+    memset(noise_sum, 0, sizeof(*noise_sum) * NOISE_GRID_H);
+    noise_accumulate(0, 4);
+    noise_accumulate(1, 2);
+    noise_accumulate(2, 2);
+
+    // Lit where smoke + centre weighting + dither beats the density threshold
+    SLICE_YIELD();
+    for(slice_row = 0; slice_row < NOISE_QH; slice_row++) {
+        int16_t level = 320 - dot_threshold * 4;
+        uint8_t y = slice_row;
+        const uint16_t* r0 = noise_sum[y >> 1];
+        const uint16_t* r1 = noise_sum[(y + 1) >> 1];
+        const uint8_t* b = bayer4[y & 3];
+        uint8_t* top = &fb[y * FB_STRIDE];
+        uint8_t* bottom = &fb[(H - 1 - y) * FB_STRIDE];
+        for(uint8_t bx = 0; bx < FB_STRIDE / 2; bx++) {
+            uint8_t bits = 0;
+            for(uint8_t i = 0; i < 8; i++) {
+                uint8_t x = bx * 8 + i;
+                // pixels between samples average their neighbours (2x upsample)
+                int16_t v = (r0[x >> 1] + r0[(x + 1) >> 1] + r1[x >> 1] + r1[(x + 1) >> 1]) >> 5;
+                int16_t centre = (x + y - (NOISE_QW + NOISE_QH) / 2) / 2;
+                bits |= (uint8_t)(3 * (v - 128) + centre + b[i & 3] * 16 > level) << i;
+            }
+            top[bx] = bottom[bx] = bits;
+            top[FB_STRIDE - 1 - bx] = bottom[FB_STRIDE - 1 - bx] = rev8(bits);
+        }
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// Polar tables for the spiral and sunburst, kept in the table cache
+//
+// Angles are in TURN units per full turn, so phases wrap with a mask. The
+// polar table covers one quadrant, |dx| = 0..64 by |dy| = 0..32 from the
+// centre, with the radius in thirds of a pixel and the angle within the
+// quadrant; polar_angle unfolds it. The sine table holds 127 * sin.
+//--------------------------------------------------------------------------------
+#define TURN 1024
+#define PI_F 3.14159265f
+#define POLAR_W (W / 2 + 1)
+#define POLAR_H (H / 2 + 1)
+#define POLAR_R_SCALE 3 // radius units per pixel
+#define SINE_AMPLITUDE 127
+
+typedef struct {
+    uint8_t r3; // radius * 3
+    uint8_t angle; // 0 .. TURN / 4, clamped to 255 on the vertical axis
+} PolarCell;
+
+#define POLAR_BYTES (sizeof(PolarCell) * POLAR_W * POLAR_H)
+#define SINE_BYTES TURN
+
+// The table hashes are FNV-1a over every parameter that shapes the table,
+// so that a table store stops handing out copies once one changes. Changes
+// to a fill function that no parameter captures have to bump
+// KAL_TABLE_VERSION by hand.
+#define KAL_TABLE_VERSION 1
+#define HASH_MIX(h, v) ((((h) ^ (uint32_t)(v)) * 16777619UL) & 0xFFFFFFFFUL)
+#define TABLE_HASH(tag, a, b, c, d) \
+    HASH_MIX(HASH_MIX(HASH_MIX(HASH_MIX(HASH_MIX(HASH_MIX(2166136261UL, tag), KAL_TABLE_VERSION), a), b), c), d)
+#define POLAR_HASH TABLE_HASH(0x706F6C72UL, POLAR_W, POLAR_H, TURN, POLAR_R_SCALE) // "polr"
+#define SINE_HASH TABLE_HASH(0x73696E65UL, SINE_BYTES, SINE_AMPLITUDE, 0, 0) // "sine"
+
+_Static_assert(CACHE_BUDGET <= UINT16_MAX, "cache offsets are 16 bits");
+_Static_assert(
+    CACHE_BUDGET >= POLAR_BYTES + 2 * SINE_BYTES,
+    "the sunburst needs the polar and sine tables at once");
+
+static void polar_fill(void* table) {
+    PolarCell (*p)[POLAR_W] = table;
+    for(uint8_t dy = 0; dy < POLAR_H; dy++) {
+        for(uint8_t dx = 0; dx < POLAR_W; dx++) {
+            float angle = atan2f(dy, dx) * (TURN / 2) / PI_F + 0.5f;
+            p[dy][dx].r3 = (uint8_t)(sqrtf(dx * dx + dy * dy) * POLAR_R_SCALE + 0.5f);
+            p[dy][dx].angle = (angle > 255) ? 255 : (uint8_t)angle;
+        }
+    }
+}
+
+static void sine_fill(void* table) {
+    int8_t* t = table;
+    for(uint16_t i = 0; i < SINE_BYTES; i++) {
+        t[i] = (int8_t)lroundf(SINE_AMPLITUDE * sinf(i * 2 * PI_F / SINE_BYTES));
+    }
+}
+
+static const PolarCell (*polar_table(void))[POLAR_W] {
+    return cache_get(CACHE_SHARED, 0, POLAR_HASH, POLAR_BYTES, polar_fill);
+}
+
+static const int8_t* sine_table(void) {
+    return cache_get(CACHE_SHARED, 0, SINE_HASH, SINE_BYTES, sine_fill);
+}
+
+// A style whose tables do not fit the cache renders blank frames. The build
+// checks that the budget can hold them all at once, but the tables of other
+// styles may still leave no gap big enough.
+static bool table_missing(void) {
+    fb_clear();
+    slice_line = 0;
+    return true;
+}
+
+// Full-turn angle of (dx, dy) from its angle within the quadrant
+static inline uint16_t polar_angle(uint8_t q, int8_t dx, int8_t dy) {
+    if(dx >= 0) return (dy >= 0) ? q : (TURN - q) & (TURN - 1);
+    return (dy >= 0) ? TURN / 2 - q : TURN / 2 + q;
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE4: Spiral swirl
+//--------------------------------------------------------------------------------
+// Lit where sin(0.3 r + 6 angle - 0.1 frame) > 0.8, i.e. where the phase is
+// within asin(0.8) .. pi - asin(0.8) = 152 .. 360 TURN units. 0.1 radians
+// are 4172 / 256 TURN units.
+#define SPIRAL_UNITS_Q8 4172
+#define SPIRAL_LO 152
+#define SPIRAL_SPAN (360 - SPIRAL_LO)
+
+static bool render_style4(void) {
+    const PolarCell (*polar)[POLAR_W] = polar_table();
+    if(!polar) return table_missing();
+    uint16_t shift = (frame * SPIRAL_UNITS_Q8) >> 8;
+    uint8_t mask[W];
+
+    SLICE_BEGIN();
+    for(slice_row = 0; slice_row < H; slice_row++) {
+        int8_t y = slice_row;
+        int8_t dy = y - H / 2;
+        const PolarCell* row = polar[dy < 0 ? -dy : dy];
+        for(int16_t x = 0; x < W; x++) {
+            int8_t dx = x - W / 2;
+            PolarCell c = row[dx < 0 ? -dx : dx];
+            // 0.3 r = 0.1 * r3
+            uint16_t phase = ((c.r3 * SPIRAL_UNITS_Q8) >> 8) + 6 * polar_angle(c.angle, dx, dy) - shift;
+            mask[x] = ((phase - SPIRAL_LO) & (TURN - 1)) <= SPIRAL_SPAN;
+        }
+        pack_mask_row(mask, &fb[y * FB_STRIDE], W, KalPackLsbFirst);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE5: Animated checkerboard wave
+//--------------------------------------------------------------------------------
+static bool render_style5(void) {
+    uint8_t mask[W];
+
+    SLICE_BEGIN();
+    for(slice_row = 0; slice_row < H; slice_row++) {
+        int y = slice_row;
+        for(int x = 0; x < W; x++) {
+            float nx = x * 0.1f + frame*0.05f;
+            float ny = y * 0.1f;
+
+            int checker = (((int)floorf(nx) + (int)floorf(ny)) & 1);
+            mask[x] = 0;
+            if(checker) {
+                float wave = sinf(nx*1.5f) * cosf(ny*1.5f);
+                mask[x] = wave > 0.3f;
+            }
+        }
+        pack_mask_row(mask, &fb[y * FB_STRIDE], W, KalPackLsbFirst);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE6: Pulsating radial sunburst
+//--------------------------------------------------------------------------------
+// cos(rays * angle + 0.08 frame) * sin(0.25 r - 0.056 frame) > 0.65, on
+// 127 * sin tables. In TURN units 0.08 frame = frame * 3338 / 256,
+// 0.056 frame = frame * 2336 / 256 and 0.25 r = r3 * 3477 / 256.
+#define SUNBURST_RAY_Q8 3338
+#define SUNBURST_RING_Q8 2336
+#define SUNBURST_R3_Q8 3477
+#define SUNBURST_LEVEL 10484 // 0.65 * 127 * 127
+
+static bool render_style6(void) {
+    const PolarCell (*polar)[POLAR_W] = polar_table(); // biggest first
+    const int8_t* sine = sine_table();
+    if(!polar || !sine) return table_missing();
+    uint8_t mask[W];
+
+    // Rays count depends on density (between 6 and 26)
+    uint8_t rays = 6 + (dot_threshold / 5);
+    uint16_t ray_shift = ((frame * SUNBURST_RAY_Q8) >> 8) + TURN / 4; // cos
+    uint16_t ring_shift = (frame * SUNBURST_RING_Q8) >> 8;
+
+    SLICE_BEGIN();
+    for(slice_row = 0; slice_row < H; slice_row++) {
+        int8_t y = slice_row;
+        int8_t dy = y - H / 2;
+        const PolarCell* row = polar[dy < 0 ? -dy : dy];
+        for(int16_t x = 0; x < W; x++) {
+            int8_t dx = x - W / 2;
+            PolarCell c = row[dx < 0 ? -dx : dx];
+
+            // Angular ray pattern
+            int8_t ray = sine[(rays * polar_angle(c.angle, dx, dy) + ray_shift) & (TURN - 1)];
+
+            // Radial pulsation
+            int8_t ring = sine[(((c.r3 * SUNBURST_R3_Q8) >> 8) - ring_shift) & (TURN - 1)];
+
+            // Combine
+            mask[x] = ray * ring > SUNBURST_LEVEL;
+        }
+        pack_mask_row(mask, &fb[y * FB_STRIDE], W, KalPackLsbFirst);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE7: Langton's ants / turmites with 4-way mirrored walkers
+//
+// Only the ANT_COUNT base walkers are stored. Every flip is applied to all
+// four mirror images of the cell, so the field stays symmetric and each
+// mirrored walker would read exactly what its base ant reads — the mirrored
+// ants are implied and cost nothing but the extra flips.
+//--------------------------------------------------------------------------------
+#define ANT_COUNT 8
+
+// Frames before the field is wiped and the walkers re-seeded
+#define ANT_LIFETIME 250
+
+// Turmite rules indexed [rule][state][cell colour]:
+// bit 7 = colour to write, bits 5..4 = turn (0 none, 1 right, 2 U-turn, 3 left),
+// bits 3..0 = next state
+#define TURMITE(write, turn, next) (uint8_t)(((write) << 7) | ((turn) << 4) | (next))
+static const uint8_t turmite_rules[2][2][2] = {
+    // Langton's ant: white → paint, turn right; black → erase, turn left
+    {{TURMITE(1, 1, 0), TURMITE(0, 3, 0)}, {TURMITE(1, 1, 0), TURMITE(0, 3, 0)}},
+    // Fibonacci spiral turmite
+    {{TURMITE(1, 3, 1), TURMITE(1, 3, 1)}, {TURMITE(1, 1, 1), TURMITE(0, 0, 0)}},
+};
+
+static const int8_t ant_dx[4] = {0, 1, 0, -1}; // N, E, S, W
+static const int8_t ant_dy[4] = {-1, 0, 1, 0};
+
+static uint8_t* ant_x;
+static uint8_t* ant_y;
+static uint8_t* ant_dir;
+static uint8_t* ant_state;
+static uint16_t ant_age = 0;
+
+static void ants_alloc(void) {
+    ARENA_NEW(ant_x, ANT_COUNT);
+    ARENA_NEW(ant_y, ANT_COUNT);
+    ARENA_NEW(ant_dir, ANT_COUNT);
+    ARENA_NEW(ant_state, ANT_COUNT);
+}
+
+static void ants_seed(void) {
+    fb_clear();
+    for(uint8_t i = 0; i < ANT_COUNT; i++) {
+        ant_x[i] = rng_next() % W;
+        ant_y[i] = rng_next() % H;
+        ant_dir[i] = rng_next() & 3;
+        ant_state[i] = 0;
+    }
+    ant_age = 0;
+}
+
+static void render_style7(void) {
+    if(style_reset || ++ant_age >= ANT_LIFETIME) ants_seed();
+
+    // Fixed number of steps per frame: more density = faster evolution,
+    // but the cost of a frame only depends on the density setting
+    uint8_t steps = 1 + dot_threshold / 4;
+
+    for(uint8_t n = 0; n < steps; n++) {
+        for(uint8_t i = 0; i < ANT_COUNT; i++) {
+            uint8_t x = ant_x[i];
+            uint8_t y = ant_y[i];
+            uint8_t cell = fb_get(x, y);
+            uint8_t rule = turmite_rules[i & 1][ant_state[i]][cell];
+
+            if((rule >> 7) != cell) {
+                fb_flip(x, y);
+                fb_flip(W - 1 - x, y);
+                fb_flip(x, H - 1 - y);
+                fb_flip(W - 1 - x, H - 1 - y);
+            }
+
+            uint8_t dir = (ant_dir[i] + ((rule >> 4) & 3)) & 3;
+            ant_dir[i] = dir;
+            ant_state[i] = rule & 0x0F;
+            ant_x[i] = (uint8_t)(x + ant_dx[dir]) % W;
+            ant_y[i] = (uint8_t)(y + ant_dy[dir]) % H;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE8: Flocking boids, simulated in one quadrant and mirrored 4 ways
+//
+// Positions and velocities are Q8.8 fixed point. Neighbour queries go
+// through a uniform grid with one cell per neighbour radius, rebuilt every
+// frame by a counting sort into static arrays, so each boid only looks at
+// the 3x3 cells around it and nothing is allocated per frame.
+//--------------------------------------------------------------------------------
+#define BOID_MAX 256
+#define BOID_MIN 32
+#define BOID_QW (W / 2)
+#define BOID_QH (H / 2)
+#define BOID_CELL_SHIFT 3 // 8px cells == neighbour radius
+#define BOID_GRID_W (BOID_QW >> BOID_CELL_SHIFT)
+#define BOID_GRID_H (BOID_QH >> BOID_CELL_SHIFT)
+#define BOID_CELLS (BOID_GRID_W * BOID_GRID_H)
+
+#define FX_ONE 256 // Q8.8
+#define BOID_RADIUS2 ((8 * FX_ONE) * (8 * FX_ONE))
+#define BOID_SEP2 ((2 * FX_ONE) * (2 * FX_ONE))
+#define BOID_MAX_SPEED (FX_ONE * 3 / 2)
+#define BOID_MIN_SPEED (FX_ONE / 2)
+#define BOID_MARGIN (4 * FX_ONE)
+#define BOID_TURN (FX_ONE / 8)
+
+static int16_t* boid_px;
+static int16_t* boid_py;
+static int16_t* boid_vx;
+static int16_t* boid_vy;
+static uint8_t* boid_cell;
+static uint16_t* boid_sorted; // boid indices by cell, 16 bits so BOID_MAX can grow
+static uint16_t* boid_cell_start; // [BOID_CELLS + 1]
+static uint16_t* boid_cell_fill; // [BOID_CELLS]
+
+static void boids_alloc(void) {
+    ARENA_NEW(boid_px, BOID_MAX);
+    ARENA_NEW(boid_py, BOID_MAX);
+    ARENA_NEW(boid_vx, BOID_MAX);
+    ARENA_NEW(boid_vy, BOID_MAX);
+    ARENA_NEW(boid_cell, BOID_MAX);
+    ARENA_NEW(boid_sorted, BOID_MAX);
+    ARENA_NEW(boid_cell_start, BOID_CELLS + 1);
+    ARENA_NEW(boid_cell_fill, BOID_CELLS);
+}
+
+static void boids_seed(void) {
+    for(uint16_t i = 0; i < BOID_MAX; i++) {
+        boid_px[i] = rng_next() % (BOID_QW * FX_ONE);
+        boid_py[i] = rng_next() % (BOID_QH * FX_ONE);
+        boid_vx[i] = (rng_next() % (2 * BOID_MAX_SPEED)) - BOID_MAX_SPEED;
+        boid_vy[i] = (rng_next() % (2 * BOID_MAX_SPEED)) - BOID_MAX_SPEED;
+    }
+}
+
+// Counting sort of the active boids by grid cell
+static void boids_build_grid(uint16_t count) {
+    memset(boid_cell_start, 0, sizeof(*boid_cell_start) * (BOID_CELLS + 1));
+    for(uint16_t i = 0; i < count; i++) {
+        uint8_t gx = (boid_px[i] / FX_ONE) >> BOID_CELL_SHIFT;
+        uint8_t gy = (boid_py[i] / FX_ONE) >> BOID_CELL_SHIFT;
+        boid_cell[i] = gy * BOID_GRID_W + gx;
+        boid_cell_start[boid_cell[i] + 1]++;
+    }
+    for(uint8_t c = 0; c < BOID_CELLS; c++) {
+        boid_cell_start[c + 1] += boid_cell_start[c];
+        boid_cell_fill[c] = boid_cell_start[c];
+    }
+    for(uint16_t i = 0; i < count; i++) {
+        boid_sorted[boid_cell_fill[boid_cell[i]]++] = i;
+    }
+}
+
+static void boids_steer(uint16_t i) {
+    int16_t px = boid_px[i];
+    int16_t py = boid_py[i];
+    int32_t sum_x = 0, sum_y = 0, sum_vx = 0, sum_vy = 0;
+    int32_t sep_x = 0, sep_y = 0;
+    int16_t n = 0;
+
+    int8_t gx = boid_cell[i] % BOID_GRID_W;
+    int8_t gy = boid_cell[i] / BOID_GRID_W;
+    for(int8_t cy = gy - 1; cy <= gy + 1; cy++) {
+        if(cy < 0 || cy >= BOID_GRID_H) continue;
+        for(int8_t cx = gx - 1; cx <= gx + 1; cx++) {
+            if(cx < 0 || cx >= BOID_GRID_W) continue;
+            uint8_t c = cy * BOID_GRID_W + cx;
+            for(uint16_t k = boid_cell_start[c]; k < boid_cell_start[c + 1]; k++) {
+                uint16_t j = boid_sorted[k];
+                if(j == i) continue;
+                int32_t dx = boid_px[j] - px;
+                int32_t dy = boid_py[j] - py;
+                int32_t d2 = dx * dx + dy * dy;
+                if(d2 >= BOID_RADIUS2) continue;
+                n++;
+                sum_x += dx;
+                sum_y += dy;
+                sum_vx += boid_vx[j];
+                sum_vy += boid_vy[j];
+                if(d2 < BOID_SEP2) {
+                    sep_x -= dx;
+                    sep_y -= dy;
+                }
+            }
+        }
+    }
+
+    int32_t vx = boid_vx[i];
+    int32_t vy = boid_vy[i];
+    if(n) {
+        // cohesion (towards the local centre), alignment, separation
+        vx += (sum_x / n) / 64 + (sum_vx / n - vx) / 8 + sep_x / 4;
+        vy += (sum_y / n) / 64 + (sum_vy / n - vy) / 8 + sep_y / 4;
+    }
+
+    // Turn away from the quadrant edges (which are the mirror axes)
+    if(px < BOID_MARGIN) vx += BOID_TURN;
+    if(px > BOID_QW * FX_ONE - BOID_MARGIN) vx -= BOID_TURN;
+    if(py < BOID_MARGIN) vy += BOID_TURN;
+    if(py > BOID_QH * FX_ONE - BOID_MARGIN) vy -= BOID_TURN;
+
+    // Clamp speed using the alpha-max-beta-min magnitude estimate
+    int32_t ax = vx < 0 ? -vx : vx;
+    int32_t ay = vy < 0 ? -vy : vy;
+    int32_t mag = (ax > ay) ? (ax + ay / 2) : (ay + ax / 2);
+    if(mag > BOID_MAX_SPEED) {
+        vx = vx * BOID_MAX_SPEED / mag;
+        vy = vy * BOID_MAX_SPEED / mag;
+    } else if(mag < BOID_MIN_SPEED && mag > 0) {
+        vx = vx * BOID_MIN_SPEED / mag;
+        vy = vy * BOID_MIN_SPEED / mag;
+    }
+    boid_vx[i] = vx;
+    boid_vy[i] = vy;
+}
+
+static void boid_plot(int16_t px, int16_t py) {
+    if(px < 0 || py < 0) return;
+    uint8_t x = px / FX_ONE;
+    uint8_t y = py / FX_ONE;
+    if(x >= BOID_QW || y >= BOID_QH) return;
+    fb_set(x, y);
+    fb_set(W - 1 - x, y);
+    fb_set(x, H - 1 - y);
+    fb_set(W - 1 - x, H - 1 - y);
+}
+
+static void render_style8(void) {
+    if(style_reset) boids_seed();
+
+    // Density sets the flock size
+    uint16_t count = BOID_MIN + (uint32_t)(BOID_MAX - BOID_MIN) * dot_threshold / 100;
+
+    boids_build_grid(count);
+    for(uint16_t i = 0; i < count; i++) {
+        boids_steer(i);
+    }
+
+    fb_clear();
+    for(uint16_t i = 0; i < count; i++) {
+        int16_t px = boid_px[i] + boid_vx[i];
+        int16_t py = boid_py[i] + boid_vy[i];
+        if(px < 0) px = 0;
+        if(py < 0) py = 0;
+        if(px >= BOID_QW * FX_ONE) px = BOID_QW * FX_ONE - 1;
+        if(py >= BOID_QH * FX_ONE) py = BOID_QH * FX_ONE - 1;
+        boid_px[i] = px;
+        boid_py[i] = py;
+
+        // head plus one pixel of tail along the heading
+        boid_plot(px, py);
+        boid_plot(px - boid_vx[i], py - boid_vy[i]);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE9: Flipping Truchet tiles
+//
+// The screen is a 16x8 grid of 8x8 tiles, so every tile row is exactly one
+// framebuffer byte and a tile is drawn by copying 8 pre-rendered bytes. The
+// framebuffer persists between frames and only tiles that change orientation
+// are redrawn, together with their three mirror images.
+//
+// A tile's orientation is a hash of the run seed, the tile and its epoch,
+// which ticks every 16 / flips frames at a phase of its own, so the tiling
+// at any frame follows from the frame number. Half the ticks draw a new
+// orientation, so about flips tiles per quadrant turn each frame. Every tile
+// keeps the frame of its next tick, so a frame only works on the tiles that
+// tick on it.
+//--------------------------------------------------------------------------------
+#define TILE 8
+#define TILES_X (W / TILE)
+#define TILES_Y (H / TILE)
+#define TRUCHET_QUADRANT_TILES (TILES_X / 2 * TILES_Y / 2)
+
+// [set][orientation][row]; orientation 1 is the horizontal mirror of 0
+static const uint8_t truchet_tiles[2][2][TILE] = {
+    // quarter arcs around opposite corners
+    {{0x18, 0x18, 0x0C, 0xC7, 0xE3, 0x30, 0x18, 0x18},
+     {0x18, 0x18, 0x30, 0xE3, 0xC7, 0x0C, 0x18, 0x18}},
+    // diagonals
+    {{0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80},
+     {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01}},
+};
+
+static uint16_t* truchet_orient; // [TILES_Y], one bit per tile
+static uint32_t* truchet_next; // [TRUCHET_QUADRANT_TILES], frame of the next tick
+
+static void truchet_alloc(void) {
+    ARENA_NEW(truchet_orient, TILES_Y);
+    ARENA_NEW(truchet_next, TRUCHET_QUADRANT_TILES);
+}
+static uint8_t truchet_set = 0;
+static uint16_t truchet_epoch_q4 = 0; // tick length the schedule was made for
+
+static void truchet_blit(uint8_t tx, uint8_t ty, uint8_t orient) {
+    const uint8_t* tile = truchet_tiles[truchet_set][orient];
+    uint8_t* dst = &fb[ty * TILE * FB_STRIDE + tx];
+    for(uint8_t r = 0; r < TILE; r++) {
+        dst[r * FB_STRIDE] = tile[r];
+    }
+}
+
+// Set a tile and its mirror images. Each reflection swaps the orientation,
+// so the diagonal opposite keeps the original one.
+static void truchet_put(uint8_t tx, uint8_t ty, uint8_t orient) {
+    uint8_t mx = TILES_X - 1 - tx;
+    uint8_t my = TILES_Y - 1 - ty;
+    truchet_orient[ty] = (truchet_orient[ty] & ~(1 << tx)) | (orient << tx);
+    truchet_orient[ty] = (truchet_orient[ty] & ~(1 << mx)) | ((orient ^ 1) << mx);
+    truchet_orient[my] = (truchet_orient[my] & ~(1 << tx)) | ((orient ^ 1) << tx);
+    truchet_orient[my] = (truchet_orient[my] & ~(1 << mx)) | (orient << mx);
+    truchet_blit(tx, ty, orient);
+    truchet_blit(mx, ty, orient ^ 1);
+    truchet_blit(tx, my, orient ^ 1);
+    truchet_blit(mx, my, orient);
+}
+
+static void render_style9(void) {
+    // Density sets how many tiles (per quadrant) turn each frame
+    uint8_t flips = 1 + dot_threshold / 10;
+    uint16_t epoch_q4 = 16 * TRUCHET_QUADRANT_TILES / 2 / flips;
+
+    // A new run, a seek or a density change invalidates the whole schedule
+    bool rebuild = style_reset || epoch_q4 != truchet_epoch_q4;
+    truchet_epoch_q4 = epoch_q4;
+    if(style_reset) truchet_set = run_hash(0, 2) & 1;
+    for(uint8_t t = 0; t < TRUCHET_QUADRANT_TILES; t++) {
+        if(!rebuild && frame < truchet_next[t]) continue;
+
+        // Epoch in ticks of epoch_q4 / 16 frames, and the first frame of the next
+        uint16_t phase = run_hash(t, 1) % epoch_q4;
+        uint32_t epoch = (frame * 16 + phase) / epoch_q4;
+        truchet_next[t] = ((epoch + 1) * epoch_q4 - phase + 15) / 16;
+
+        uint8_t tx = t % (TILES_X / 2);
+        uint8_t ty = t / (TILES_X / 2);
+        uint8_t orient = run_hash(t, epoch) & 1;
+        if(style_reset || orient != ((truchet_orient[ty] >> tx) & 1)) truchet_put(tx, ty, orient);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE10: Maze carving and solving, mirrored 4 ways
+//
+// A 32x16 cell maze fills the top-left quadrant (cells on even pixels, the
+// odd pixels between them are passages). It is carved by a randomized DFS,
+// then a BFS flood erases it from the outer corner until it reaches the
+// centre, and the solution path is traced back. Walls and visited flags are
+// bit grids, and one fixed array serves as the DFS stack and the BFS queue.
+// Every phase runs a bounded number of O(1) steps per frame.
+//--------------------------------------------------------------------------------
+#define MAZE_W 32
+#define MAZE_H 16
+#define MAZE_CELLS (MAZE_W * MAZE_H)
+#define MAZE_GOAL (MAZE_CELLS - 1)
+#define MAZE_HOLD_FRAMES 30
+
+typedef enum {
+    MazeCarve,
+    MazeSolve,
+    MazeTrace,
+    MazeHold,
+} MazePhase;
+
+static uint32_t* maze_open_e; // bit cx: passage from (cx, cy) to (cx + 1, cy)
+static uint32_t* maze_open_s; // bit cx: passage from (cx, cy) to (cx, cy + 1)
+static uint32_t* maze_seen;
+static uint16_t* maze_work; // DFS stack while carving, BFS queue while solving
+static uint8_t* maze_from; // direction back to the BFS parent
+static uint16_t maze_head = 0;
+static uint16_t maze_tail = 0;
+static uint8_t maze_phase = MazeCarve;
+static uint8_t maze_timer = 0;
+
+static void maze_alloc(void) {
+    ARENA_NEW(maze_open_e, MAZE_H);
+    ARENA_NEW(maze_open_s, MAZE_H);
+    ARENA_NEW(maze_seen, MAZE_H);
+    ARENA_NEW(maze_work, MAZE_CELLS);
+    ARENA_NEW(maze_from, MAZE_CELLS);
+}
+
+static inline bool maze_is_seen(uint8_t cx, uint8_t cy) {
+    return (maze_seen[cy] >> cx) & 1;
+}
+
+static inline void maze_mark_seen(uint8_t cx, uint8_t cy) {
+    maze_seen[cy] |= 1UL << cx;
+}
+
+// Neighbour of (cx, cy) in direction dir (same N/E/S/W order as the
+// turmites), or false if it is outside the maze
+static bool maze_step(uint8_t cx, uint8_t cy, uint8_t dir, uint8_t* nx, uint8_t* ny) {
+    int8_t x = cx + ant_dx[dir];
+    int8_t y = cy + ant_dy[dir];
+    if(x < 0 || y < 0 || x >= MAZE_W || y >= MAZE_H) return false;
+    *nx = x;
+    *ny = y;
+    return true;
+}
+
+static bool maze_is_open(uint8_t cx, uint8_t cy, uint8_t dir) {
+    switch(dir) {
+        case 0: return cy > 0 && ((maze_open_s[cy - 1] >> cx) & 1);
+        case 1: return (maze_open_e[cy] >> cx) & 1;
+        case 2: return (maze_open_s[cy] >> cx) & 1;
+        default: return cx > 0 && ((maze_open_e[cy] >> (cx - 1)) & 1);
+    }
+}
+
+static void maze_open(uint8_t cx, uint8_t cy, uint8_t dir) {
+    switch(dir) {
+        case 0: maze_open_s[cy - 1] |= 1UL << cx; break;
+        case 1: maze_open_e[cy] |= 1UL << cx; break;
+        case 2: maze_open_s[cy] |= 1UL << cx; break;
+        default: maze_open_e[cy] |= 1UL << (cx - 1); break;
+    }
+}
+
+static void maze_plot(uint8_t x, uint8_t y, bool on) {
+    if(on) {
+        fb_set(x, y);
+        fb_set(W - 1 - x, y);
+        fb_set(x, H - 1 - y);
+        fb_set(W - 1 - x, H - 1 - y);
+    } else {
+        fb_reset(x, y);
+        fb_reset(W - 1 - x, y);
+        fb_reset(x, H - 1 - y);
+        fb_reset(W - 1 - x, H - 1 - y);
+    }
+}
+
+// Draw a cell and the passage pixel leading out of it in direction dir
+static void maze_plot_link(uint8_t cx, uint8_t cy, uint8_t dir, bool on) {
+    maze_plot(cx * 2, cy * 2, on);
+    maze_plot(cx * 2 + ant_dx[dir], cy * 2 + ant_dy[dir], on);
+}
+
+static void maze_seed(void) {
+    fb_clear();
+    memset(maze_open_e, 0, sizeof(*maze_open_e) * MAZE_H);
+    memset(maze_open_s, 0, sizeof(*maze_open_s) * MAZE_H);
+    memset(maze_seen, 0, sizeof(*maze_seen) * MAZE_H);
+    maze_mark_seen(0, 0);
+    maze_work[0] = 0;
+    maze_head = 1;
+    maze_phase = MazeCarve;
+    maze_plot(0, 0, true);
+}
+
+static void maze_solve_start(void) {
+    memset(maze_seen, 0, sizeof(*maze_seen) * MAZE_H);
+    maze_mark_seen(0, 0);
+    maze_work[0] = 0;
+    maze_head = 0;
+    maze_tail = 1;
+    maze_phase = MazeSolve;
+    maze_plot(0, 0, false);
+
+    // Join the four mirrored goal cells around the centre of the screen
+    maze_plot(MAZE_W * 2 - 1, MAZE_H * 2 - 2, true);
+    maze_plot(MAZE_W * 2 - 2, MAZE_H * 2 - 1, true);
+}
+
+static void maze_carve_step(void) {
+    if(maze_head == 0) {
+        maze_solve_start();
+        return;
+    }
+
+    uint16_t cell = maze_work[maze_head - 1];
+    uint8_t cx = cell % MAZE_W;
+    uint8_t cy = cell / MAZE_W;
+    uint8_t options[4];
+    uint8_t n = 0;
+    uint8_t nx, ny;
+    for(uint8_t dir = 0; dir < 4; dir++) {
+        if(maze_step(cx, cy, dir, &nx, &ny) && !maze_is_seen(nx, ny)) options[n++] = dir;
+    }
+    if(n == 0) {
+        maze_head--; // dead end: backtrack
+        return;
+    }
+
+    uint8_t dir = options[rng_next() % n];
+    maze_step(cx, cy, dir, &nx, &ny);
+    maze_open(cx, cy, dir);
+    maze_mark_seen(nx, ny);
+    maze_work[maze_head++] = ny * MAZE_W + nx;
+    maze_plot_link(nx, ny, dir ^ 2, true);
+}
+
+static void maze_solve_step(void) {
+    if(maze_head == maze_tail) {
+        maze_phase = MazeHold; // unreachable goal; cannot happen in a perfect maze
+        return;
+    }
+
+    uint16_t cell = maze_work[maze_head++];
+    if(cell == MAZE_GOAL) {
+        maze_head = cell; // the trace walks back from the goal
+        maze_phase = MazeTrace;
+        return;
+    }
+
+    uint8_t cx = cell % MAZE_W;
+    uint8_t cy = cell / MAZE_W;
+    uint8_t nx, ny;
+    for(uint8_t dir = 0; dir < 4; dir++) {
+        if(!maze_is_open(cx, cy, dir) || !maze_step(cx, cy, dir, &nx, &ny)) continue;
+        if(maze_is_seen(nx, ny)) continue;
+        maze_mark_seen(nx, ny);
+        uint16_t next = ny * MAZE_W + nx;
+        maze_from[next] = dir ^ 2;
+        maze_work[maze_tail++] = next;
+        maze_plot_link(nx, ny, dir ^ 2, false);
+    }
+}
+
+static void maze_trace_step(void) {
+    uint16_t cell = maze_head;
+    uint8_t cx = cell % MAZE_W;
+    uint8_t cy = cell / MAZE_W;
+    if(cell == 0) {
+        maze_plot(0, 0, true);
+        maze_timer = 0;
+        maze_phase = MazeHold;
+        return;
+    }
+
+    uint8_t dir = maze_from[cell];
+    maze_plot_link(cx, cy, dir, true);
+    maze_step(cx, cy, dir, &cx, &cy);
+    maze_head = cy * MAZE_W + cx;
+}
+
+static void render_style10(void) {
+    if(style_reset) maze_seed();
+
+    // Density sets the number of carve/solve/trace steps per frame
+    uint8_t steps = 2 + dot_threshold / 4;
+    for(uint8_t n = 0; n < steps; n++) {
+        switch(maze_phase) {
+            case MazeCarve: maze_carve_step(); break;
+            case MazeSolve: maze_solve_step(); break;
+            case MazeTrace: maze_trace_step(); break;
+            default: break;
+        }
+    }
+    if(maze_phase == MazeHold && ++maze_timer >= MAZE_HOLD_FRAMES) maze_seed();
+}
+
+//--------------------------------------------------------------------------------
+// Grid simulation storage
+//
+// The grid simulations own by far the largest buffers in the engine. Only
+// one style runs at a time and each re-seeds itself at the start of a run,
+// so both take their buffers from the same stretch of the arena.
+//--------------------------------------------------------------------------------
+#define RIPPLE_W (W / 2)
+#define RIPPLE_H (H / 2)
+#define RIPPLE_STRIDE (RIPPLE_W + 2)
+#define RIPPLE_CELLS (RIPPLE_STRIDE * (RIPPLE_H + 2))
+
+#define GS_W (W / 2)
+#define GS_H (H / 2)
+#define GS_STRIDE (GS_W + 2)
+#define GS_CELLS (GS_STRIDE * (GS_H + 2))
+
+static int16_t (*ripple_h)[RIPPLE_CELLS]; // 2 height maps: 8976 bytes
+static int16_t (*gs_u)[GS_CELLS]; // 2 species, double buffered: 17952 bytes
+static int16_t (*gs_v)[GS_CELLS];
+
+static void ripple_alloc(void) {
+    ARENA_NEW(ripple_h, 2);
+}
+
+static void gs_alloc(void) {
+    ARENA_NEW(gs_u, 2);
+    ARENA_NEW(gs_v, 2);
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE11: Ripple tank
+//
+// Discrete 2D wave equation on two 64x32 int16 height buffers that swap
+// roles every frame: next = (left + right) / 2 + (up + down) / 2 - prev,
+// then damped by next >> RIPPLE_DAMPING. A ghost border copied from the
+// edges each frame makes the boundary reflective and keeps the inner loop
+// free of branches. On the device the loop works on two cells per word
+// with the Cortex-M4 DSP instructions; elsewhere it is a plain loop the
+// compiler can vectorize. Both paths give bit-identical results.
+// Drops land at four mirrored positions, so the tank stays symmetric.
+//--------------------------------------------------------------------------------
+#define RIPPLE_DAMPING 5
+#define RIPPLE_DROP 1000
+#define RIPPLE_LEVEL 8 // height per Bayer step when dithering
+
+static uint8_t ripple_cur = 0;
+
+static void ripple_reflect_edges(int16_t* h) {
+    memcpy(&h[1], &h[RIPPLE_STRIDE + 1], RIPPLE_W * sizeof(int16_t));
+    memcpy(
+        &h[(RIPPLE_H + 1) * RIPPLE_STRIDE + 1],
+        &h[RIPPLE_H * RIPPLE_STRIDE + 1],
+        RIPPLE_W * sizeof(int16_t));
+    for(uint8_t y = 1; y <= RIPPLE_H; y++) {
+        h[y * RIPPLE_STRIDE] = h[y * RIPPLE_STRIDE + 1];
+        h[y * RIPPLE_STRIDE + RIPPLE_W + 1] = h[y * RIPPLE_STRIDE + RIPPLE_W];
+    }
+}
+
+#ifdef DSP_INTRINSICS
+static inline uint32_t ripple_load2(const int16_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v)); // unaligned LDR is fine on Cortex-M4
+    return v;
+}
+#endif
+
+static void ripple_step(void) {
+    int16_t* cur = ripple_h[ripple_cur];
+    int16_t* next = ripple_h[ripple_cur ^ 1]; // still holds the previous frame
+    ripple_reflect_edges(cur);
+
+    for(uint8_t y = 1; y <= RIPPLE_H; y++) {
+        const int16_t* c = &cur[y * RIPPLE_STRIDE + 1];
+        const int16_t* up = c - RIPPLE_STRIDE;
+        const int16_t* down = c + RIPPLE_STRIDE;
+        int16_t* n = &next[y * RIPPLE_STRIDE + 1];
+#ifdef DSP_INTRINSICS
+        for(uint8_t x = 0; x < RIPPLE_W; x += 2) {
+            uint32_t lr = __SHADD16(ripple_load2(c + x - 1), ripple_load2(c + x + 1));
+            uint32_t ud = __SHADD16(ripple_load2(up + x), ripple_load2(down + x));
+            uint32_t v = __SSUB16(__SADD16(lr, ud), ripple_load2(n + x));
+            uint32_t damp = v;
+            for(uint8_t i = 0; i < RIPPLE_DAMPING; i++) {
+                damp = __SHADD16(damp, 0); // per-lane arithmetic shift right by one
+            }
+            v = __SSUB16(v, damp);
+            memcpy(n + x, &v, sizeof(v));
+        }
+#else
+        for(uint8_t x = 0; x < RIPPLE_W; x++) {
+            int16_t v = ((c[x - 1] + c[x + 1]) >> 1) + ((up[x] + down[x]) >> 1) - n[x];
+            n[x] = v - (v >> RIPPLE_DAMPING);
+        }
+#endif
+    }
+    ripple_cur ^= 1;
+}
+
+static void ripple_drop(void) {
+    int16_t* h = ripple_h[ripple_cur];
+    uint8_t x = 1 + rng_next() % (RIPPLE_W / 2);
+    uint8_t y = 1 + rng_next() % (RIPPLE_H / 2);
+    uint8_t xs[2] = {x, RIPPLE_W + 1 - x};
+    uint8_t ys[2] = {y, RIPPLE_H + 1 - y};
+    for(uint8_t i = 0; i < 4; i++) {
+        int16_t* p = &h[ys[i >> 1] * RIPPLE_STRIDE + xs[i & 1]];
+        p[0] -= RIPPLE_DROP;
+        p[-1] -= RIPPLE_DROP / 2;
+        p[1] -= RIPPLE_DROP / 2;
+        p[-RIPPLE_STRIDE] -= RIPPLE_DROP / 2;
+        p[RIPPLE_STRIDE] -= RIPPLE_DROP / 2;
+    }
+}
+
+// Upscale tank row ty to screen rows 2 ty and 2 ty + 1 while dithering the
+// wave crests to 1bpp. A crest lights a pixel when it is above
+// (bayer + 1) * RIPPLE_LEVEL, i.e. when its level (v - 1) / RIPPLE_LEVEL
+// reaches the dither threshold bayer + 1.
+static void ripple_draw_row(uint8_t ty) {
+    const int16_t* row = &ripple_h[ripple_cur][(ty + 1) * RIPPLE_STRIDE + 1];
+    uint8_t level[W];
+    if(!dither_rows[0][0]) dither_rows_init();
+    for(uint8_t x = 0; x < RIPPLE_W; x++) {
+        int16_t v = (row[x] - 1) / RIPPLE_LEVEL;
+        level[2 * x] = level[2 * x + 1] = (v < 0) ? 0 : (v > 255) ? 255 : v;
+    }
+    for(uint8_t y = 2 * ty; y < 2 * ty + 2; y++) {
+        pack_threshold_row(level, dither_rows[y & 3], &fb[y * FB_STRIDE], W, KalPackLsbFirst);
+    }
+}
+
+static bool render_style11(void) {
+    SLICE_BEGIN();
+    if(style_reset) {
+        memset(ripple_h, 0, sizeof(*ripple_h) * 2);
+        ripple_cur = 0;
+    }
+
+    // OK drops a ripple; density sets the rate of spontaneous rain drops
+    if(poke_pending || (rng_next() % 100) < dot_threshold / 5) ripple_drop();
+
+    ripple_step();
+    SLICE_YIELD();
+    for(slice_row = 0; slice_row < RIPPLE_H; slice_row++) {
+        ripple_draw_row(slice_row);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE12: Gray-Scott reaction-diffusion (Turing patterns)
+//
+// Both species are int16 fixed point with 12 fraction bits on a 64x32 grid
+// that forms the top-left quadrant; the other three are its mirror images.
+// (With only 8 fraction bits the diffusion terms round to zero and the
+// pattern freezes after a few hundred iterations.) The ghost border copies
+// the edge cells, which makes every edge a mirror, so the pattern runs
+// seamlessly across the axes. The fields live in the shared simulation
+// storage. As many iterations as fit in the time budget run each frame.
+//--------------------------------------------------------------------------------
+#define GS_SHIFT 12
+#define GS_ONE (1 << GS_SHIFT)
+#define GS_DU (GS_ONE / 20) // Du = 1.0 over the Laplacian scale of 20
+#define GS_DV (GS_ONE / 40) // Dv = 0.5
+#define GS_MAX_ITERATIONS 16
+
+// Feed / kill rates giving distinct Turing regimes
+#define GS_RATE(r) (uint16_t)((r) * GS_ONE + 0.5f)
+static const uint16_t gs_presets[][2] = {
+    {GS_RATE(0.055f), GS_RATE(0.062f)}, // coral growth
+    {GS_RATE(0.039f), GS_RATE(0.058f)}, // worms
+    {GS_RATE(0.035f), GS_RATE(0.060f)}, // spots
+    {GS_RATE(0.025f), GS_RATE(0.055f)}, // mitosis
+};
+
+static uint8_t gs_cur = 0;
+static uint16_t gs_feed = 0;
+static uint16_t gs_kill = 0;
+
+// Copy the edge cells into the ghost border, corners included
+static void gs_reflect_edges(int16_t* f) {
+    for(uint8_t y = 1; y <= GS_H; y++) {
+        f[y * GS_STRIDE] = f[y * GS_STRIDE + 1];
+        f[y * GS_STRIDE + GS_W + 1] = f[y * GS_STRIDE + GS_W];
+    }
+    memcpy(&f[0], &f[GS_STRIDE], GS_STRIDE * sizeof(int16_t));
+    memcpy(&f[(GS_H + 1) * GS_STRIDE], &f[GS_H * GS_STRIDE], GS_STRIDE * sizeof(int16_t));
+}
+
+static void gs_seed(void) {
+    const uint16_t* preset = gs_presets[rng_next() % COUNT_OF(gs_presets)];
+    gs_feed = preset[0];
+    gs_kill = preset[1];
+    gs_cur = 0;
+
+    int16_t* u = gs_u[0];
+    int16_t* v = gs_v[0];
+    for(uint16_t i = 0; i < GS_CELLS; i++) {
+        u[i] = GS_ONE;
+        v[i] = 0;
+    }
+    for(uint8_t n = 0; n < 6; n++) {
+        uint8_t cx = 1 + rng_next() % (GS_W - 6);
+        uint8_t cy = 1 + rng_next() % (GS_H - 6);
+        for(uint8_t y = cy; y < cy + 5; y++) {
+            for(uint8_t x = cx; x < cx + 5; x++) {
+                u[y * GS_STRIDE + x] = GS_ONE / 2;
+                v[y * GS_STRIDE + x] = GS_ONE / 4;
+            }
+        }
+    }
+}
+
+// 9-point Laplacian scaled by 20: edge weight 4, corner weight 1
+static inline int32_t gs_laplacian(const int16_t* f, uint16_t i) {
+    return 4 * (f[i - 1] + f[i + 1] + f[i - GS_STRIDE] + f[i + GS_STRIDE]) +
+           f[i - GS_STRIDE - 1] + f[i - GS_STRIDE + 1] + f[i + GS_STRIDE - 1] +
+           f[i + GS_STRIDE + 1] - 20 * f[i];
+}
+
+static void gs_step(void) {
+    const int16_t* u = gs_u[gs_cur];
+    const int16_t* v = gs_v[gs_cur];
+    int16_t* nu = gs_u[gs_cur ^ 1];
+    int16_t* nv = gs_v[gs_cur ^ 1];
+    gs_reflect_edges((int16_t*)u);
+    gs_reflect_edges((int16_t*)v);
+
+    int32_t feed = gs_feed;
+    int32_t decay = gs_feed + gs_kill;
+    for(uint8_t y = 1; y <= GS_H; y++) {
+        for(uint16_t i = y * GS_STRIDE + 1; i <= y * GS_STRIDE + GS_W; i++) {
+            int32_t cu = u[i];
+            int32_t cv = v[i];
+            int32_t lap_u = gs_laplacian(u, i);
+            int32_t lap_v = gs_laplacian(v, i);
+            int32_t uvv = (((cu * cv) >> GS_SHIFT) * cv) >> GS_SHIFT;
+            int32_t diff_u = (GS_DU * lap_u + GS_ONE / 2) >> GS_SHIFT;
+            int32_t diff_v = (GS_DV * lap_v + GS_ONE / 2) >> GS_SHIFT;
+            nu[i] = cu + diff_u - uvv + ((feed * (GS_ONE - cu) + GS_ONE / 2) >> GS_SHIFT);
+            nv[i] = cv + diff_v + uvv - ((decay * cv + GS_ONE / 2) >> GS_SHIFT);
+        }
+    }
+    gs_cur ^= 1;
+}
+
+// Dither row y of V onto the top-left quadrant and mirror it into the other
+// three
+static void gs_draw_row(uint8_t y) {
+    const int16_t* row = &gs_v[gs_cur][(y + 1) * GS_STRIDE + 1];
+    const uint8_t* b = bayer4[y & 3];
+    uint8_t* top = &fb[y * FB_STRIDE];
+    uint8_t* bottom = &fb[(H - 1 - y) * FB_STRIDE];
+    for(uint8_t bx = 0; bx < FB_STRIDE / 2; bx++) {
+        uint8_t bits = 0;
+        for(uint8_t i = 0; i < 8; i++) {
+            bits |= (uint8_t)(row[bx * 8 + i] > (b[i & 3] * 2 + 1) * (GS_ONE / 80)) << i;
+        }
+        top[bx] = bottom[bx] = bits;
+        top[FB_STRIDE - 1 - bx] = bottom[FB_STRIDE - 1 - bx] = rev8(bits);
+    }
+}
+
+static bool render_style12(void) {
+    // Density sets the time budget, and so the speed of growth. The budget
+    // runs on while the frame is yielded.
+    uint32_t budget_us = 1000 + dot_threshold * 150;
+
+    SLICE_BEGIN();
+    if(style_reset) gs_seed();
+    budget_left(budget_us, 0);
+    slice_row = 0;
+    do {
+        gs_step();
+        SLICE_YIELD();
+    } while(++slice_row < GS_MAX_ITERATIONS && budget_left(budget_us, slice_row));
+
+    for(slice_row = 0; slice_row < GS_H; slice_row++) {
+        gs_draw_row(slice_row);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE13: Digital rain, falling from both edges towards the middle
+//
+// Each of the 128 columns has a speed, a phase and a wait between drops in
+// small arrays. A column's drops fall in a fixed cycle of wait + RAIN_H +
+// RAIN_MAX_TRAIL pixels, and each cycle's drop gets a trail length hashed
+// from the cycle number, so where every drop is follows from the frame
+// number. The framebuffer persists between frames, so a column only draws
+// the span its head moved over and erases the span its tail left behind. A
+// frame therefore costs O(columns), however long the trails are. The top
+// half is mirrored into the bottom half.
+//--------------------------------------------------------------------------------
+#define RAIN_H (H / 2)
+#define RAIN_MIN_SPEED 4 // Q4.4: 0.25 px per frame
+#define RAIN_MAX_SPEED 32 // Q4.4: 2 px per frame
+#define RAIN_MIN_TRAIL 4
+#define RAIN_MAX_TRAIL 24
+
+static uint8_t* rain_speed; // Q4.4 px per frame
+static uint8_t* rain_wait; // px of cycle spent waiting above the screen
+static uint16_t* rain_phase; // Q4.4 px into the cycle at frame 0
+static uint8_t rain_density; // density the waits were drawn for
+
+static void rain_alloc(void) {
+    ARENA_NEW(rain_speed, W);
+    ARENA_NEW(rain_wait, W);
+    ARENA_NEW(rain_phase, W);
+}
+
+// Set or clear rows y0..y1 of column x (clipped to the top half) and the
+// mirrored rows of the bottom half
+static void rain_span(uint8_t x, int16_t y0, int16_t y1, bool on) {
+    if(y0 < 0) y0 = 0;
+    if(y1 > RAIN_H - 1) y1 = RAIN_H - 1;
+    if(y0 > y1) return;
+    uint8_t mask = 1 << (x & 7);
+    uint8_t* top = &fb[y0 * FB_STRIDE + (x >> 3)];
+    uint8_t* bottom = &fb[(H - 1 - y0) * FB_STRIDE + (x >> 3)];
+    for(int16_t y = y0; y <= y1; y++) {
+        if(on) {
+            *top |= mask;
+            *bottom |= mask;
+        } else {
+            *top &= (uint8_t)~mask;
+            *bottom &= (uint8_t)~mask;
+        }
+        top += FB_STRIDE;
+        bottom -= FB_STRIDE;
+    }
+}
+
+// Give every column its speed and phase; density shortens the waits
+// between drops
+static void rain_seed(void) {
+    uint8_t wait = 8 + (100 - dot_threshold);
+    for(uint8_t x = 0; x < W; x++) {
+        uint32_t h = run_hash(x, 3);
+        rain_speed[x] = RAIN_MIN_SPEED + h % (RAIN_MAX_SPEED - RAIN_MIN_SPEED + 1);
+        rain_wait[x] = (h >> 8) % wait;
+        rain_phase[x] = (h >> 16) % ((rain_wait[x] + RAIN_H + RAIN_MAX_TRAIL) * 16);
+    }
+    rain_density = dot_threshold;
+}
+
+typedef struct {
+    uint32_t cycle;
+    int16_t head; // px, negative while waiting
+    uint8_t trail;
+} RainDrop;
+
+// The drop of column x at frame f
+static RainDrop rain_drop(uint8_t x, uint32_t f) {
+    uint32_t pos = f * rain_speed[x] + rain_phase[x];
+    uint16_t cycle_q4 = (rain_wait[x] + RAIN_H + RAIN_MAX_TRAIL) * 16;
+    RainDrop d;
+    d.cycle = pos / cycle_q4;
+    d.head = (int16_t)((pos % cycle_q4) >> 4) - rain_wait[x];
+    d.trail = RAIN_MIN_TRAIL + run_hash(x, d.cycle) % (RAIN_MAX_TRAIL - RAIN_MIN_TRAIL + 1);
+    return d;
+}
+
+static void render_style13(void) {
+    bool redraw = style_reset || dot_threshold != rain_density;
+    if(redraw) {
+        rain_seed();
+        fb_clear();
+    }
+
+    for(uint8_t x = 0; x < W; x++) {
+        RainDrop now = rain_drop(x, frame);
+        if(redraw) {
+            rain_span(x, now.head + 1 - now.trail, now.head, true);
+            continue;
+        }
+        RainDrop was = rain_drop(x, frame - 1);
+        if(now.cycle != was.cycle) {
+            // the last drop is gone (or nearly so) and a new one waits
+            rain_span(x, was.head + 1 - was.trail, was.head, false);
+            rain_span(x, now.head + 1 - now.trail, now.head, true);
+        } else if(now.head != was.head) {
+            rain_span(x, was.head + 1, now.head, true);
+            rain_span(x, was.head + 1 - was.trail, now.head - now.trail, false);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE14: Rotating shaded torus
+//
+// The "donut" demo in fixed point. The surface is sampled on a grid of tube
+// angle theta by ring angle phi, every sample rotated by the frame's angles
+// A (about x) and B (about z) and projected, and it is drawn where it is
+// nearer than what the int8 z-buffer holds: lit if its Lambert luminance
+// beats the Bayer threshold of its pixel, dark otherwise. Sines and cosines
+// are Q14, and the grid is walked by rotating (cos, sin) pairs on by the
+// step angle, so the only trig calls are the few per frame that set up the
+// angles. Around one ring the rotated position and luminance are linear in
+// (cos phi, sin phi), with coefficients worked out once per ring. Density
+// sets the grid step; low densities leave the surface dotted.
+//--------------------------------------------------------------------------------
+#define TORUS_ONE (1 << 14) // Q14
+#define TORUS_R2 (2 * TORUS_ONE) // ring radius; the tube radius is one
+#define TORUS_K2 (5 * TORUS_ONE) // distance of the viewer
+#define TORUS_K1 40 // px per unit at distance one
+#define TORUS_L_MAX 23170 // sqrt(2), the brightest luminance
+#define TORUS_SPIN_A 11 // TURN units per frame
+#define TORUS_SPIN_B 5
+
+typedef struct {
+    int32_t c;
+    int32_t s;
+} TorusRot;
+
+static int8_t* torus_z; // [W * H], scaled 1 / z, 0 where nothing is drawn
+static TorusRot torus_tube; // tube angle of the ring to draw next
+
+static void torus_alloc(void) {
+    ARENA_NEW(torus_z, W * H);
+}
+
+static TorusRot torus_rot(float angle) {
+    return (TorusRot){lroundf(cosf(angle) * TORUS_ONE), lroundf(sinf(angle) * TORUS_ONE)};
+}
+
+static inline void torus_turn(TorusRot* r, TorusRot step) {
+    int32_t c = (r->c * step.c - r->s * step.s) >> 14;
+    r->s = (r->s * step.c + r->c * step.s) >> 14;
+    r->c = c;
+}
+
+// Draw the ring of samples at tube angle torus_tube
+static void torus_draw_ring(TorusRot a, TorusRot b, TorusRot step, uint16_t steps) {
+    int32_t ct = torus_tube.c;
+    int32_t st = torus_tube.s;
+    int32_t cx = TORUS_R2 + ct; // the tube's circle, before rotation
+    int32_t cy = st;
+    int32_t cy_ca = (cy * a.c) >> 14;
+    int32_t sa_sb = (a.s * b.s) >> 14;
+    int32_t sa_cb = (a.s * b.c) >> 14;
+
+    // x = cp * xc + sp * xs + x0, and likewise for y, z and the luminance
+    int32_t xc = (cx * b.c) >> 14, xs = (cx * sa_sb) >> 14, x0 = -((cy_ca * b.s) >> 14);
+    int32_t yc = (cx * b.s) >> 14, ys = -((cx * sa_cb) >> 14), y0 = (cy_ca * b.c) >> 14;
+    int32_t zs = (cx * a.c) >> 14, z0 = TORUS_K2 + ((cy * a.s) >> 14);
+    int32_t lc = (ct * b.s) >> 14, ls = -((ct * (a.c + sa_cb)) >> 14);
+    int32_t l0 = (st * (((a.c * b.c) >> 14) - a.s)) >> 14;
+
+    TorusRot ring = {TORUS_ONE, 0};
+    for(uint16_t i = 0; i < steps; i++, torus_turn(&ring, step)) {
+        int32_t z = ((ring.s * zs) >> 14) + z0;
+        int32_t ooz = (TORUS_K1 << 20) / z;
+        int32_t x = ((ring.c * xc + ring.s * xs) >> 14) + x0;
+        int32_t y = ((ring.c * yc + ring.s * ys) >> 14) + y0;
+        int16_t px = W / 2 + ((x * ooz) >> 20);
+        int16_t py = H / 2 - ((y * ooz) >> 20);
+        if(px < 0 || py < 0 || px >= W || py >= H) continue;
+
+        int8_t depth = ooz >> 4;
+        int8_t* zb = &torus_z[py * W + px];
+        if(depth <= *zb) continue;
+        *zb = depth;
+        int32_t l = ((ring.c * lc + ring.s * ls) >> 14) + l0;
+        if(l > (bayer4[py & 3][px & 3] * 2 + 1) * (TORUS_L_MAX / 32)) {
+            fb_set(px, py);
+        } else {
+            fb_reset(px, py);
+        }
+    }
+}
+
+static bool render_style14(void) {
+    uint16_t tube_steps = 24 + dot_threshold * 3 / 4;
+    uint16_t ring_steps = tube_steps * 3;
+    TorusRot a = torus_rot((frame * TORUS_SPIN_A % TURN) * 2 * PI_F / TURN);
+    TorusRot b = torus_rot((frame * TORUS_SPIN_B % TURN) * 2 * PI_F / TURN);
+    TorusRot tube_step = torus_rot(2 * PI_F / tube_steps);
+    TorusRot ring_step = torus_rot(2 * PI_F / ring_steps);
+
+    SLICE_BEGIN();
+    fb_clear();
+    memset(torus_z, 0, W * H);
+    torus_tube = (TorusRot){TORUS_ONE, 0};
+    for(slice_row = 0; slice_row < tube_steps; slice_row++) {
+        torus_draw_ring(a, b, ring_step, ring_steps);
+        torus_turn(&torus_tube, tube_step);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE15: Raymarched signed-distance scene, amortised over four frames
+//
+// A spinning torus above a field of spheres (one sphere, repeated by folding
+// space into a cell), seen by a camera circling it, raymarched at 64x32 in
+// Q8 fixed point and upscaled with ordered dithering. Each frame marches
+// only the quarter of the pixels whose turn it is in a 2x2 pattern, and
+// keeps the other three quarters from the frames before, so the per-pixel
+// work costs a quarter as much. As every pixel shows the scene at the last
+// frame of its phase, any frame can be rebuilt at once by marching every
+// pixel at its own time, which the first frame after a seek does. Rays stop
+// on a hit, past SDF_FAR or after as many steps as density allows. A hit is
+// lit by how fast the distance grows towards the light, one more evaluation
+// instead of the six of a normal, and fades with distance.
+//--------------------------------------------------------------------------------
+#define SDF_W (W / 2)
+#define SDF_H (H / 2)
+#define SDF_ONE 256 // Q8 positions and distances
+#define SDF_DIR_ONE 4096 // Q12 directions and rotations
+#define SDF_FOCAL (SDF_W * 6 / 5) // in half pixels
+#define SDF_PITCH 0.2f // radians down, so that the torus is centred
+#define SDF_CAMERA (5 * SDF_ONE) // orbit radius
+#define SDF_EYE SDF_ONE // camera height
+#define SDF_RING SDF_ONE // torus ring radius
+#define SDF_TUBE (SDF_ONE * 35 / 100)
+#define SDF_BALL (SDF_ONE * 45 / 100)
+#define SDF_BALL_Y (-SDF_ONE * 14 / 10) // height of the sphere field
+#define SDF_CELL (2 * SDF_ONE) // sphere spacing, a power of two
+#define SDF_HIT 2
+#define SDF_FAR (12 * SDF_ONE)
+#define SDF_LIGHT_STEP (SDF_ONE / 8)
+#define SDF_LIGHT_SIDE 1636 // light direction relative to the camera, Q12
+#define SDF_LIGHT_UP 3273
+#define SDF_LIGHT_BACK 1841
+#define SDF_AMBIENT 2 // dither level of unlit surfaces
+#define SDF_ORBIT 6 // TURN units per frame
+#define SDF_SPIN 9
+
+typedef struct {
+    int32_t ox, oz; // camera position, at height SDF_EYE
+    int32_t cy, sy; // camera yaw
+    int32_t cs, ss; // torus spin about the x axis
+    int32_t lx, ly, lz; // towards the light, which moves with the camera
+} SdfView;
+
+static uint8_t (*sdf_shade)[SDF_W]; // [SDF_H], dither levels 0..16
+
+static void sdf_alloc(void) {
+    ARENA_NEW(sdf_shade, SDF_H);
+}
+
+// Frame (mod 4) on which each pixel of a 2x2 block is marched
+static const uint8_t sdf_phase[2][2] = {{0, 2}, {3, 1}};
+
+static inline int32_t sdf_len(int32_t x, int32_t y, int32_t z) {
+    return (int32_t)sqrtf((float)(x * x + y * y + z * z));
+}
+
+static void sdf_view(SdfView* v, int32_t t) {
+    float yaw = ((t * SDF_ORBIT) & (TURN - 1)) * 2 * PI_F / TURN;
+    float spin = ((t * SDF_SPIN) & (TURN - 1)) * 2 * PI_F / TURN;
+    v->cy = lroundf(cosf(yaw) * SDF_DIR_ONE);
+    v->sy = lroundf(sinf(yaw) * SDF_DIR_ONE);
+    v->cs = lroundf(cosf(spin) * SDF_DIR_ONE);
+    v->ss = lroundf(sinf(spin) * SDF_DIR_ONE);
+    v->ox = (SDF_CAMERA * v->sy) >> 12;
+    v->oz = (SDF_CAMERA * v->cy) >> 12;
+    // Up, to the left and behind the camera
+    v->lx = (-SDF_LIGHT_SIDE * v->cy + SDF_LIGHT_BACK * v->sy) >> 12;
+    v->ly = SDF_LIGHT_UP;
+    v->lz = (SDF_LIGHT_SIDE * v->sy + SDF_LIGHT_BACK * v->cy) >> 12;
+}
+
+static int32_t sdf_scene(const SdfView* v, int32_t x, int32_t y, int32_t z) {
+    int32_t ty = (y * v->cs - z * v->ss) >> 12;
+    int32_t tz = (y * v->ss + z * v->cs) >> 12;
+    int32_t torus = sdf_len(sdf_len(x, 0, tz) - SDF_RING, ty, 0) - SDF_TUBE;
+    int32_t cx = ((x + SDF_CELL / 2) & (SDF_CELL - 1)) - SDF_CELL / 2;
+    int32_t cz = ((z + SDF_CELL / 2) & (SDF_CELL - 1)) - SDF_CELL / 2;
+    int32_t ball = sdf_len(cx, y - SDF_BALL_Y, cz) - SDF_BALL;
+    return (torus < ball) ? torus : ball;
+}
+
+// Dither level of pixel (x, y) as seen from v
+static uint8_t sdf_march(const SdfView* v, uint8_t x, uint8_t y, uint8_t steps) {
+    // Ray through the pixel centre in camera space (right, up, forward),
+    // pitched down, then turned by the yaw
+    float u = 2 * x - (SDF_W - 1);
+    float w = (SDF_H - 1) - 2 * y;
+    float n = SDF_DIR_ONE / sqrtf(u * u + w * w + SDF_FOCAL * SDF_FOCAL);
+    float cp = cosf(SDF_PITCH), sp = sinf(SDF_PITCH);
+    int32_t ru = lroundf(u * n);
+    int32_t rv = lroundf((w * cp - SDF_FOCAL * sp) * n);
+    int32_t rf = lroundf((w * sp + SDF_FOCAL * cp) * n);
+    int32_t dx = (ru * v->cy - rf * v->sy) >> 12;
+    int32_t dz = (-ru * v->sy - rf * v->cy) >> 12;
+
+    int32_t t = 0;
+    for(uint8_t i = 0; i < steps; i++) {
+        int32_t px = v->ox + ((dx * t) >> 12);
+        int32_t py = SDF_EYE + ((rv * t) >> 12);
+        int32_t pz = v->oz + ((dz * t) >> 12);
+        int32_t d = sdf_scene(v, px, py, pz);
+        if(d < SDF_HIT) {
+            int32_t lit = sdf_scene(
+                              v,
+                              px + ((v->lx * SDF_LIGHT_STEP) >> 12),
+                              py + ((v->ly * SDF_LIGHT_STEP) >> 12),
+                              pz + ((v->lz * SDF_LIGHT_STEP) >> 12)) -
+                          d;
+            if(lit <= 0) return SDF_AMBIENT;
+            if(lit > SDF_LIGHT_STEP) lit = SDF_LIGHT_STEP;
+            return SDF_AMBIENT +
+                   lit * (2 * SDF_FAR - t) * (16 - SDF_AMBIENT) / (SDF_LIGHT_STEP * 2 * SDF_FAR);
+        }
+        t += d;
+        if(t > SDF_FAR) break;
+    }
+    return 0;
+}
+
+// Upscale row y to screen rows 2 y and 2 y + 1, dithered
+static void sdf_draw_row(uint8_t y) {
+    uint8_t level[W];
+    if(!dither_rows[0][0]) dither_rows_init();
+    for(uint8_t x = 0; x < SDF_W; x++) {
+        level[2 * x] = level[2 * x + 1] = sdf_shade[y][x];
+    }
+    for(uint8_t sy = 2 * y; sy < 2 * y + 2; sy++) {
+        pack_threshold_row(level, dither_rows[sy & 3], &fb[sy * FB_STRIDE], W, KalPackLsbFirst);
+    }
+}
+
+static bool render_style15(void) {
+    uint8_t steps = 8 + dot_threshold * 24 / 100;
+    uint8_t now = frame & 3;
+    SdfView views[4]; // the scene at the last frame of each phase
+    for(uint8_t k = 0; k < 4; k++) {
+        sdf_view(&views[k], (int32_t)frame - (int32_t)((frame - k) & 3));
+    }
+
+    SLICE_BEGIN();
+    for(slice_row = 0; slice_row < SDF_H; slice_row++) {
+        uint8_t y = slice_row;
+        for(uint8_t x = 0; x < SDF_W; x++) {
+            uint8_t k = sdf_phase[y & 1][x & 1];
+            if(k == now || style_reset) sdf_shade[y][x] = sdf_march(&views[k], x, y, steps);
+        }
+        sdf_draw_row(y);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE16: Fourier epicycles, tracing closed shapes mirrored four ways
+//
+// A shape is a sum of rotating vectors (epicycles) c_k e^(i k t), one per
+// harmonic k, and the pen sits at the tip of the chain. Each frame turns
+// every vector on by its own step e^(i k 2 pi / EPI_STEPS), a complex
+// fixed-point multiply, and draws only the segment the pen moved along, so
+// the shape builds up in the framebuffer over EPI_STEPS frames. The steps
+// are powers of the base step, multiplied out once per shape, so nothing
+// calls sinf. Coefficients are Q8 pixels, sorted by amplitude, and density
+// sets how many of them take part: a circle at 0, the full shape at 100. A
+// finished shape is held for EPI_HOLD frames before the next one starts,
+// and redrawing one up to any frame takes at most EPI_STEPS steps, so seeks
+// and density changes replay the current shape.
+//--------------------------------------------------------------------------------
+#define EPI_TERMS 16
+#define EPI_STEPS 256 // frames per turn of the base harmonic
+#define EPI_HOLD 30
+#define EPI_CYCLE (EPI_STEPS + EPI_HOLD)
+#define EPI_BASE_C 1073418433L // e^(i 2 pi / EPI_STEPS), Q30
+#define EPI_BASE_S 26350943L
+
+typedef struct {
+    int8_t k;
+    int16_t re; // Q8 pixels, y up
+    int16_t im;
+} EpiTerm;
+
+typedef struct {
+    uint8_t count;
+    EpiTerm terms[EPI_TERMS];
+} EpiShape;
+
+static const EpiShape epi_shapes[] = {
+    {8, {// star
+        {1, 0, 5456}, {-4, 0, 1319}, {6, 0, 586}, {-14, 0, 108}, {16, 0, 82}, {-9, 0, 67},
+        {11, 0, 45}, {-19, 0, 15}
+    }},
+    {8, {// heart
+        {-1, 0, 5647}, {-3, 0, -1355}, {2, 0, -1129}, {-2, 0, -1129}, {3, 0, 452}, {-4, 0, -226},
+        {4, 0, -226}, {1, 0, 226}
+    }},
+    {16, {// house
+        {1, -4106, -3967}, {0, 0, -1197}, {-2, -500, -17}, {-1, 235, -227}, {-4, 19, -282},
+        {-3, -118, -131}, {4, -9, -127}, {6, -121, 12}, {-5, -89, 75}, {5, -52, -44}, {7, 39, -49},
+        {-7, -34, -44}, {-10, -51, -9}, {2, 47, -2}, {3, -25, 27}, {12, -7, -36}
+    }},
+    {10, {// square
+        {1, 4492, 4492}, {-3, 499, 499}, {5, 180, 180}, {-7, 92, 92}, {9, 56, 56}, {-11, 37, 37},
+        {13, 27, 27}, {-15, 20, 20}, {17, 16, 16}, {-19, 13, 13}
+    }},
+    {4, {// figure eight
+        {-1, 3777, 0}, {1, 3777, 0}, {-2, -2266, 0}, {2, 2266, 0}
+    }},
+};
+
+static int32_t (*epi_vec)[2]; // [EPI_TERMS], Q16 pixels
+static int32_t (*epi_turn)[2]; // [EPI_TERMS], Q30
+static uint8_t epi_count = 0; // terms taking part
+static uint16_t epi_pos = 0; // steps traced of the current shape
+static int16_t epi_x, epi_y; // pen, on screen
+static uint8_t epi_density;
+
+static void epi_alloc(void) {
+    ARENA_NEW(epi_vec, EPI_TERMS);
+    ARENA_NEW(epi_turn, EPI_TERMS);
+}
+
+// v *= c + i s, with c and s in Q30
+static inline void epi_rotate(int32_t* v, int32_t c, int32_t s) {
+    int32_t re = ((int64_t)v[0] * c - (int64_t)v[1] * s) >> 30;
+    v[1] = ((int64_t)v[0] * s + (int64_t)v[1] * c) >> 30;
+    v[0] = re;
+}
+
+static void epi_pen(void) {
+    int32_t x = 0, y = 0;
+    for(uint8_t i = 0; i < epi_count; i++) {
+        x += epi_vec[i][0];
+        y += epi_vec[i][1];
+    }
+    epi_x = W / 2 + ((x + 0x8000) >> 16);
+    epi_y = H / 2 - ((y + 0x8000) >> 16);
+}
+
+// Put the vectors of shape at t = 0, and work out their steps
+static void epi_seed(const EpiShape* shape) {
+    epi_count = 1 + dot_threshold * (EPI_TERMS - 1) / KAL_DENSITY_MAX;
+    if(epi_count > shape->count) epi_count = shape->count;
+    for(uint8_t i = 0; i < epi_count; i++) {
+        const EpiTerm* term = &shape->terms[i];
+        epi_vec[i][0] = term->re * 256;
+        epi_vec[i][1] = term->im * 256;
+        int32_t* turn = epi_turn[i];
+        turn[0] = 1L << 30;
+        turn[1] = 0;
+        for(uint8_t k = 0; k < (term->k < 0 ? -term->k : term->k); k++) {
+            epi_rotate(turn, EPI_BASE_C, EPI_BASE_S);
+        }
+        if(term->k < 0) turn[1] = -turn[1];
+    }
+    epi_pos = 0;
+    epi_density = dot_threshold;
+    epi_pen();
+}
+
+static void epi_plot(int16_t x, int16_t y) {
+    fb_plot(x, y);
+    fb_plot(W - 1 - x, y);
+    fb_plot(x, H - 1 - y);
+    fb_plot(W - 1 - x, H - 1 - y);
+}
+
+// Move the pen one step on, drawing the segment it covers
+static void epi_step(void) {
+    for(uint8_t i = 0; i < epi_count; i++) {
+        epi_rotate(epi_vec[i], epi_turn[i][0], epi_turn[i][1]);
+    }
+    int16_t x = epi_x, y = epi_y;
+    epi_pen();
+    int16_t dx = abs(epi_x - x), sx = (x < epi_x) ? 1 : -1;
+    int16_t dy = -abs(epi_y - y), sy = (y < epi_y) ? 1 : -1;
+    int16_t err = dx + dy;
+    for(;;) {
+        epi_plot(x, y);
+        if(x == epi_x && y == epi_y) break;
+        int16_t e2 = 2 * err;
+        if(e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if(e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    epi_pos++;
+}
+
+static void render_style16(void) {
+    uint32_t cycle = (frame - 1) / EPI_CYCLE;
+    uint16_t pos = (frame - 1) % EPI_CYCLE;
+    if(style_reset || pos == 0 || dot_threshold != epi_density) {
+        fb_clear();
+        epi_seed(&epi_shapes[cycle % COUNT_OF(epi_shapes)]);
+    }
+    uint16_t target = (pos < EPI_STEPS) ? pos + 1 : EPI_STEPS;
+    while(epi_pos < target) epi_step();
+}
+
+//--------------------------------------------------------------------------------
+// NEW-STYLE17: Spectral synthesis through a fixed-point inverse FFT
+//
+// A few peaks wander across a 64x32 spectrum, each turning its phase, and
+// every frame the image is synthesised from it with a 2D inverse FFT, then
+// thresholded at zero and upscaled 2x. The spectrum is kept Hermitian
+// (F(-k) = conj F(k)), so the image is real and only columns kx = 0..32 are
+// stored. A peak between bins is spread over its four neighbours, which
+// makes it glide instead of jump. The column pass runs 33 inverse FFTs of
+// 32 points; after it every row's spectrum is Hermitian too, so the row
+// pass packs two rows into one complex 64-point FFT (row a in the real
+// part, row b in the imaginary part) and needs only 16. The FFT is radix-2
+// and in place, on int32 values with Q14 twiddles from a table in flash.
+// Density sets the number of peaks.
+//--------------------------------------------------------------------------------
+#define FFT_W (W / 2)
+#define FFT_H (H / 2)
+#define FFT_COLS (FFT_W / 2 + 1)
+#define SPEC_MIN_PEAKS 2
+#define SPEC_MAX_PEAKS 8
+#define SPEC_AMP 1024 // per peak; keeps every FFT value below 2^16
+
+// e^(2 pi i k / 64) for k = 0..31, Q14
+static const int16_t fft_twiddle[FFT_W / 2][2] = {
+    {16384, 0}, {16305, 1606}, {16069, 3196}, {15679, 4756}, {15137, 6270}, {14449, 7723},
+    {13623, 9102}, {12665, 10394}, {11585, 11585}, {10394, 12665}, {9102, 13623}, {7723, 14449},
+    {6270, 15137}, {4756, 15679}, {3196, 16069}, {1606, 16305}, {0, 16384}, {-1606, 16305},
+    {-3196, 16069}, {-4756, 15679}, {-6270, 15137}, {-7723, 14449}, {-9102, 13623},
+    {-10394, 12665}, {-11585, 11585}, {-12665, 10394}, {-13623, 9102}, {-14449, 7723},
+    {-15137, 6270}, {-15679, 4756}, {-16069, 3196}, {-16305, 1606}
+};
+
+static int32_t (*spec)[FFT_H][2]; // [FFT_COLS], column kx holds ky = 0..31
+static int32_t (*spec_row)[2]; // [FFT_W]
+
+static void spec_alloc(void) {
+    ARENA_NEW(spec, FFT_COLS);
+    ARENA_NEW(spec_row, FFT_W);
+}
+
+// In-place inverse FFT of 2^log2n points (log2n <= 6), without the 1 / n.
+// Magnitudes must stay below 2^16 for the Q14 products to fit.
+static void fft_inverse(int32_t (*x)[2], uint8_t log2n) {
+    uint16_t n = 1 << log2n;
+    for(uint16_t i = 0, j = 0; i < n; i++) {
+        if(i < j) {
+            int32_t re = x[i][0], im = x[i][1];
+            x[i][0] = x[j][0];
+            x[i][1] = x[j][1];
+            x[j][0] = re;
+            x[j][1] = im;
+        }
+        uint16_t bit = n >> 1;
+        while(j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+    for(uint16_t half = 1; half < n; half <<= 1) {
+        uint8_t stride = FFT_W / (2 * half);
+        for(uint16_t k = 0; k < half; k++) {
+            int32_t wr = fft_twiddle[k * stride][0];
+            int32_t wi = fft_twiddle[k * stride][1];
+            for(uint16_t i = k; i < n; i += 2 * half) {
+                int32_t* a = x[i];
+                int32_t* b = x[i + half];
+                int32_t tr = (b[0] * wr - b[1] * wi) >> 14;
+                int32_t ti = (b[0] * wi + b[1] * wr) >> 14;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+// Add re + i im at bin (kx, ky) and its conjugate at (-kx, -ky), whichever
+// of the two is stored
+static void spec_add(int16_t kx, int16_t ky, int32_t re, int32_t im) {
+    if(kx < 0) {
+        kx = -kx;
+        ky = -ky;
+        im = -im;
+    }
+    spec[kx][ky & (FFT_H - 1)][0] += re;
+    spec[kx][ky & (FFT_H - 1)][1] += im;
+    if(kx == 0) {
+        spec[0][-ky & (FFT_H - 1)][0] += re;
+        spec[0][-ky & (FFT_H - 1)][1] -= im;
+    }
+}
+
+// Place the peaks of this frame. Each one circles a centre of its own in
+// the low frequencies, its phase turning as it goes.
+static void spec_build(void) {
+    uint8_t peaks = SPEC_MIN_PEAKS + dot_threshold * (SPEC_MAX_PEAKS - SPEC_MIN_PEAKS) / KAL_DENSITY_MAX;
+    memset(spec, 0, sizeof(*spec) * FFT_COLS);
+    for(uint8_t p = 0; p < peaks; p++) {
+        uint32_t h = run_hash(p, 5);
+        float t = frame * (0.01f + (h & 15) * 0.002f);
+        float kx = (int8_t)((h >> 4) % 9) - 4 + 2 * sinf(t + p);
+        float ky = (int8_t)((h >> 8) % 7) - 3 + 2 * cosf(1.3f * t);
+        float phase = frame * ((int8_t)((h >> 12) % 9) - 4) * 0.05f;
+        int32_t re = lroundf(cosf(phase) * SPEC_AMP);
+        int32_t im = lroundf(sinf(phase) * SPEC_AMP);
+
+        // Bilinear split over the four bins around (kx, ky), weights in Q8
+        int16_t x0 = floorf(kx), y0 = floorf(ky);
+        int32_t fx = lroundf((kx - x0) * 256), fy = lroundf((ky - y0) * 256);
+        for(uint8_t q = 0; q < 4; q++) {
+            int32_t w = ((q & 1) ? fx : 256 - fx) * ((q & 2) ? fy : 256 - fy) >> 8;
+            spec_add(x0 + (q & 1), y0 + (q >> 1), (re * w) >> 8, (im * w) >> 8);
+        }
+    }
+}
+
+// Rows a and a + 1 from their half spectra, then to screen rows 2 a .. 2 a + 3
+static void spec_draw_rows(uint8_t a) {
+    for(uint8_t kx = 0; kx < FFT_W; kx++) {
+        bool mirrored = kx >= FFT_COLS;
+        const int32_t* ga = spec[mirrored ? FFT_W - kx : kx][a];
+        const int32_t* gb = spec[mirrored ? FFT_W - kx : kx][a + 1];
+        int32_t sign = mirrored ? -1 : 1; // conjugate past the middle
+        spec_row[kx][0] = ga[0] - sign * gb[1];
+        spec_row[kx][1] = sign * ga[1] + gb[0];
+    }
+    fft_inverse(spec_row, 6);
+
+    uint8_t mask[W];
+    for(uint8_t r = 0; r < 2; r++) {
+        for(uint8_t x = 0; x < FFT_W; x++) {
+            mask[2 * x] = mask[2 * x + 1] = spec_row[x][r] > 0;
+        }
+        for(uint8_t y = 2 * (a + r); y < 2 * (a + r) + 2; y++) {
+            pack_mask_row(mask, &fb[y * FB_STRIDE], W, KalPackLsbFirst);
+        }
+    }
+}
+
+static bool render_style17(void) {
+    SLICE_BEGIN();
+    spec_build();
+    for(slice_row = 0; slice_row < FFT_COLS; slice_row++) {
+        fft_inverse(spec[slice_row], 5);
+        SLICE_YIELD();
+    }
+    for(slice_row = 0; slice_row < FFT_H; slice_row += 2) {
+        spec_draw_rows(slice_row);
+        SLICE_YIELD();
+    }
+    SLICE_END();
+}
+
+//--------------------------------------------------------------------------------
+// Post-processing: bit-parallel morphology on the packed framebuffer
+//
+// A framebuffer row is four little-endian 32-bit words with the leftmost
+// pixel in bit 0, so a word shifted left by one holds every pixel's left
+// neighbour (plus the carry from the previous word) and a word shifted
+// right holds its right neighbour. A 3x3 dilation is then the OR of a row
+// with both shifts, ORed again with the rows above and below; erosion is
+// the same with AND. Pixels past the edges repeat the edge pixels, which
+// leaves borders untouched by either operation. Each pass is a few
+// hundred word operations, cheap enough to put behind any style.
+// The passes are driven by the filter chain below.
+//--------------------------------------------------------------------------------
+#define FB_WORDS (W / 32)
+
+static uint32_t (*morph_tmp)[FB_WORDS]; // [H]
+
+_Static_assert(FB_WORDS * 4 == FB_STRIDE, "fb rows must be whole 32-bit words");
+
+static void morph_pass(uint32_t (*src)[FB_WORDS], uint32_t (*dst)[FB_WORDS], bool dilate) {
+    // Horizontal: combine each pixel with its left and right neighbours
+    for(uint8_t y = 0; y < H; y++) {
+        const uint32_t* r = src[y];
+        for(uint8_t k = 0; k < FB_WORDS; k++) {
+            uint32_t w = r[k];
+            uint32_t left = (w << 1) | (k > 0 ? r[k - 1] >> 31 : w & 1);
+            uint32_t right = (w >> 1) | (k < FB_WORDS - 1 ? r[k + 1] << 31 : w & 0x80000000UL);
+            morph_tmp[y][k] = dilate ? (w | left | right) : (w & left & right);
+        }
+    }
+
+    // Vertical: combine each row with the rows above and below
+    for(uint8_t y = 0; y < H; y++) {
+        const uint32_t* up = morph_tmp[y > 0 ? y - 1 : y];
+        const uint32_t* mid = morph_tmp[y];
+        const uint32_t* down = morph_tmp[y < H - 1 ? y + 1 : y];
+        for(uint8_t k = 0; k < FB_WORDS; k++) {
+            dst[y][k] = dilate ? (up[k] | mid[k] | down[k]) : (up[k] & mid[k] & down[k]);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Post-processing filter chain
+//
+// A chain is an ordered list of buffer-to-buffer steps run on a copy of fb
+// (styles may keep state in fb, so it is never filtered in place). Most
+// steps are row maps: output row y is some function of a single input row.
+// The executor fuses every run of adjacent row maps into one pass over the
+// rows, finding each output row's source by walking the run backwards and
+// then applying the row transforms forwards on a four-word row in registers.
+// Only the neighbourhood steps (morphology) need a pass of their own. Passes
+// run in place when the rows stay where they are, and otherwise ping-pong
+// between two preallocated buffers.
+//--------------------------------------------------------------------------------
+#define FILTER_MAX_STEPS 4
+
+typedef enum {
+    // Row maps
+    FilterInvert,
+    FilterMirror, // left half mirrored onto the right half
+    FilterRotate180,
+    FilterScroll, // a, b: pixels per frame right / down, wrapping around
+    FilterFold, // top-left quadrant mirrored into all four
+    FilterMask, // a: 0 = circle, 1 = diamond
+    // Neighbourhood operations
+    FilterDilate,
+    FilterErode,
+    FilterOutline, // dilation XOR input
+} FilterOp;
+
+typedef struct {
+    uint8_t op;
+    int8_t a;
+    int8_t b;
+} FilterStep;
+
+typedef struct {
+    uint8_t count;
+    FilterStep steps[FILTER_MAX_STEPS];
+} FilterChain;
+
+// Presets cycled by a long press on OK
+static const FilterChain filter_presets[] = {
+    {0}, // off
+    {1, {{FilterDilate, 0, 0}}}, // thicken
+    {1, {{FilterErode, 0, 0}}}, // thin
+    {2, {{FilterErode, 0, 0}, {FilterDilate, 0, 0}}}, // open: drop specks
+    {2, {{FilterDilate, 0, 0}, {FilterErode, 0, 0}}}, // close: fill gaps
+    {1, {{FilterOutline, 0, 0}}},
+    {1, {{FilterInvert, 0, 0}}},
+    {1, {{FilterMirror, 0, 0}}},
+    {1, {{FilterFold, 0, 0}}}, // kaleidoscope
+    {2, {{FilterScroll, 1, 1}, {FilterFold, 0, 0}}}, // drifting kaleidoscope
+    {2, {{FilterMask, 0, 0}, {FilterRotate180, 0, 0}}}, // spotlight, upside down
+    {3, {{FilterOutline, 0, 0}, {FilterInvert, 0, 0}, {FilterMask, 1, 0}}}, // inverted outline diamond
+};
+
+static uint32_t (*filter_buf)[H][FB_WORDS]; // [2]
+static uint8_t* filter_circle; // [H], half-widths of the circle mask
+
+static inline uint32_t rev32(uint32_t v) {
+#ifdef __ARM_ARCH_7EM__
+    return __RBIT(v);
+#else
+    v = ((v >> 1) & 0x55555555UL) | ((v & 0x55555555UL) << 1);
+    v = ((v >> 2) & 0x33333333UL) | ((v & 0x33333333UL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0FUL) | ((v & 0x0F0F0F0FUL) << 4);
+    v = ((v >> 8) & 0x00FF00FFUL) | ((v & 0x00FF00FFUL) << 8);
+    return (v >> 16) | (v << 16);
+#endif
+}
+
+static inline bool filter_is_row_map(uint8_t op) {
+    return op < FilterDilate;
+}
+
+// Input row that a row map reads to produce output row y
+static uint8_t filter_source_row(const FilterStep* st, uint8_t y) {
+    switch(st->op) {
+        case FilterRotate180: return H - 1 - y;
+        case FilterScroll: return (y + H - (st->b * (int32_t)(frame % H) % H + H) % H) % H;
+        case FilterFold: return (y < H / 2) ? y : H - 1 - y;
+        default: return y;
+    }
+}
+
+static void filter_span_mask(uint32_t* m, int16_t x0, int16_t x1) {
+    for(uint8_t k = 0; k < FB_WORDS; k++) {
+        int16_t lo = x0 - k * 32;
+        int16_t hi = x1 - k * 32;
+        if(hi < 0 || lo > 31) {
+            m[k] = 0;
+            continue;
+        }
+        uint32_t upper = (hi >= 31) ? 0xFFFFFFFFUL : ((2UL << hi) - 1);
+        uint32_t lower = (lo <= 0) ? 0 : ((1UL << lo) - 1);
+        m[k] = upper & ~lower;
+    }
+}
+
+// Transform one row in place; y is the output row this step produces
+static void filter_row(const FilterStep* st, uint32_t* row, uint8_t y) {
+    uint32_t t[FB_WORDS];
+    switch(st->op) {
+        case FilterInvert:
+            for(uint8_t k = 0; k < FB_WORDS; k++) {
+                row[k] = ~row[k];
+            }
+            break;
+        case FilterMirror:
+        case FilterFold:
+            for(uint8_t k = 0; k < FB_WORDS / 2; k++) {
+                row[FB_WORDS - 1 - k] = rev32(row[k]);
+            }
+            break;
+        case FilterRotate180:
+            memcpy(t, row, sizeof(t));
+            for(uint8_t k = 0; k < FB_WORDS; k++) {
+                row[k] = rev32(t[FB_WORDS - 1 - k]);
+            }
+            break;
+        case FilterScroll: {
+            uint8_t shift = (st->a * (int32_t)(frame % W) % W + W) % W;
+            uint8_t q = shift / 32;
+            uint8_t r = shift % 32;
+            memcpy(t, row, sizeof(t));
+            for(uint8_t k = 0; k < FB_WORDS; k++) {
+                uint32_t w = t[(k + FB_WORDS - q) % FB_WORDS];
+                uint32_t carry = t[(k + 2 * FB_WORDS - q - 1) % FB_WORDS];
+                row[k] = r ? (w << r) | (carry >> (32 - r)) : w;
+            }
+            break;
+        }
+        case FilterMask: {
+            int16_t hw;
+            if(st->a == 0) {
+                hw = filter_circle[y];
+            } else {
+                int16_t dy = (y < H / 2) ? (H / 2 - 1 - y) : (y - H / 2);
+                hw = H / 2 - dy;
+            }
+            filter_span_mask(t, W / 2 - hw, W / 2 - 1 + hw);
+            for(uint8_t k = 0; k < FB_WORDS; k++) {
+                row[k] &= t[k];
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+// One fused pass over n adjacent row-map steps
+static void filter_run_rows(
+    const FilterStep* steps,
+    uint8_t n,
+    uint32_t (*src)[FB_WORDS],
+    uint32_t (*dst)[FB_WORDS]) {
+    uint8_t out_y[FILTER_MAX_STEPS];
+    uint32_t row[FB_WORDS];
+    for(uint8_t y = 0; y < H; y++) {
+        out_y[n - 1] = y;
+        for(uint8_t i = n - 1; i > 0; i--) {
+            out_y[i - 1] = filter_source_row(&steps[i], out_y[i]);
+        }
+        memcpy(row, src[filter_source_row(&steps[0], out_y[0])], sizeof(row));
+        for(uint8_t i = 0; i < n; i++) {
+            filter_row(&steps[i], row, out_y[i]);
+        }
+        memcpy(dst[y], row, sizeof(row));
+    }
+}
+
+// Run a chain on a copy of the last complete frame and return the result
+static const uint8_t* filter_apply(const FilterChain* chain) {
+    if(chain->count == 0) return fb_front;
+
+    if(!filter_circle[H / 2]) {
+        for(uint8_t y = 0; y < H; y++) {
+            float dy = y + 0.5f - H / 2;
+            filter_circle[y] = (uint8_t)(sqrtf((H / 2) * (H / 2) - dy * dy) + 0.5f);
+        }
+    }
+
+    uint8_t cur = 0;
+    memcpy(filter_buf[cur], fb_front, sizeof(filter_buf[cur]));
+    for(uint8_t i = 0; i < chain->count;) {
+        const FilterStep* st = &chain->steps[i];
+        if(filter_is_row_map(st->op)) {
+            uint8_t n = 1;
+            bool in_place = true;
+            while(i + n < chain->count && filter_is_row_map(chain->steps[i + n].op)) n++;
+            for(uint8_t j = 0; j < n; j++) {
+                uint8_t op = chain->steps[i + j].op;
+                if(op == FilterRotate180 || op == FilterScroll || op == FilterFold) in_place = false;
+            }
+            uint8_t dst = in_place ? cur : cur ^ 1;
+            filter_run_rows(st, n, filter_buf[cur], filter_buf[dst]);
+            cur = dst;
+            i += n;
+        } else {
+            morph_pass(filter_buf[cur], filter_buf[cur ^ 1], st->op != FilterErode);
+            if(st->op == FilterOutline) {
+                for(uint8_t y = 0; y < H; y++) {
+                    for(uint8_t k = 0; k < FB_WORDS; k++) {
+                        filter_buf[cur ^ 1][y][k] ^= filter_buf[cur][y][k];
+                    }
+                }
+            }
+            cur ^= 1;
+            i++;
+        }
+    }
+    return (const uint8_t*)filter_buf[cur];
+}
+
+//--------------------------------------------------------------------------------
+// General render switcher (reordered)
+//--------------------------------------------------------------------------------
+// Advance the current style by one frame into fb, or by as much of it as the
+// yield callback allows when may_yield is set. True once the frame is done.
+static bool render_slice(bool may_yield) {
+    if(!slice_active) {
+        frame++;
+        cache_clock++;
+        slice_active = true;
+    }
+    slice_may_yield = may_yield;
+
+    bool done = true;
+    switch(style) {
+        case 0: render_style2(); break; // rotated star
+        case 1: render_style1(); break; // arcs
+        case 2: done = render_style3(); break; // noise
+        case 3: done = render_style0(); break; // mirrored dots
+        case 4: done = render_style4(); break; // spiral swirl
+        case 5: done = render_style5(); break; // checkerboard
+        case 6: done = render_style6(); break; // sunburst
+        case 7: render_style7(); break; // turmites
+        case 8: render_style8(); break; // boids
+        case 9: render_style9(); break; // truchet tiles
+        case 10: render_style10(); break; // maze
+        case 11: done = render_style11(); break; // ripple tank
+        case 12: done = render_style12(); break; // reaction-diffusion
+        case 13: render_style13(); break; // digital rain
+        case 14: done = render_style14(); break; // torus
+        case 15: done = render_style15(); break; // raymarched scene
+        case 16: render_style16(); break; // epicycles
+        case 17: done = render_style17(); break; // spectral synthesis
+        default: done = render_style0(); break;
+    }
+    if(!done) return false;
+
+    slice_active = false;
+    style_reset = false;
+    poke_pending = false;
+    memcpy(fb_front, fb, FB_BYTES);
+    return true;
+}
+
+static void render_frame(void) {
+    render_slice(false);
+}
+
+// Buffers that live for as long as the engine
+static void shared_alloc(void) {
+    ARENA_NEW(cache_base, CACHE_BUDGET);
+    ARENA_NEW(cache_entries, CACHE_SLOTS);
+    ARENA_NEW(fb, FB_BYTES);
+    ARENA_NEW(fb_front, FB_BYTES);
+    ARENA_NEW(dither_rows, 4);
+    ARENA_NEW(morph_tmp, H);
+    ARENA_NEW(filter_buf, 2);
+    ARENA_NEW(filter_circle, H);
+}
+
+// Buffers of one style, for the length of a run
+static void style_alloc(uint8_t s) {
+    switch(s) {
+        case 2: noise_alloc(); break;
+        case 7: ants_alloc(); break;
+        case 8: boids_alloc(); break;
+        case 9: truchet_alloc(); break;
+        case 10: maze_alloc(); break;
+        case 11: ripple_alloc(); break;
+        case 12: gs_alloc(); break;
+        case 13: rain_alloc(); break;
+        case 14: torus_alloc(); break;
+        case 15: sdf_alloc(); break;
+        case 16: epi_alloc(); break;
+        case 17: spec_alloc(); break;
+        default: break;
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Public API
+//--------------------------------------------------------------------------------
+size_t kal_arena_size(void) {
+    static size_t size = 0;
+    if(!size) {
+        // Runs before kal_init hands over a block (it asks first), so the
+        // allocations below only move the offsets
+        arena_used = 0;
+        shared_alloc();
+        size_t shared = arena_used;
+        for(uint8_t s = 0; s < STYLE_COUNT; s++) {
+            arena_used = shared;
+            style_alloc(s);
+            if(arena_used > size) size = arena_used;
+        }
+    }
+    return size;
+}
+
+bool kal_init(void* arena, size_t size) {
+    if(!arena || ((uintptr_t)arena & (ARENA_ALIGN - 1)) || size < kal_arena_size()) return false;
+    arena_base = arena;
+    arena_used = 0;
+    arena_peak = 0;
+    shared_alloc();
+    arena_shared = arena_used;
+    memset(&cache_stats, 0, sizeof(cache_stats));
+    cache_stats.budget = CACHE_BUDGET;
+    style = 0xFF;
+    run_pristine = false;
+    return true;
+}
+
+size_t kal_arena_used(void) {
+    return arena_used;
+}
+
+size_t kal_arena_peak(void) {
+    return arena_peak;
+}
+
+void kal_start(uint8_t s, uint8_t density, uint32_t seed) {
+    arena_used = arena_shared;
+    style_alloc(s);
+    style = s;
+    dot_threshold = density;
+    style_reset = true;
+    poke_pending = false;
+    frame = 0;
+    run_seed = seed;
+    run_pristine = true;
+    slice_active = false;
+    slice_line = 0;
+    rng_seed(seed);
+    fb_clear();
+}
+
+void kal_set_density(uint8_t density) {
+    if(density == dot_threshold) return;
+    dot_threshold = density;
+    run_pristine = false;
+}
+
+void kal_poke(void) {
+    poke_pending = true;
+    run_pristine = false;
+}
+
+const uint8_t* kal_next_frame(void) {
+    render_frame();
+    return fb_front;
+}
+
+bool kal_render_slice(void) {
+    return render_slice(true);
+}
+
+const uint8_t* kal_frame(void) {
+    return fb_front;
+}
+
+uint8_t kal_style(void) {
+    return style;
+}
+
+uint8_t kal_density(void) {
+    return dot_threshold;
+}
+
+uint32_t kal_frames_rendered(void) {
+    return frame;
+}
+
+bool kal_seekable(uint8_t s) {
+    return style_seekable(s);
+}
+
+bool kal_seek(uint32_t target) {
+    if(style >= STYLE_COUNT || target == 0) return false;
+    if(style_seekable(style)) {
+        frame = target - 1;
+        style_reset = true;
+        slice_active = false;
+        slice_line = 0;
+        return true;
+    }
+
+    // Simulations get there the long way, replaying from the start if they
+    // have to go back
+    if(slice_active) render_frame();
+    if(frame >= target) kal_start(style, dot_threshold, run_seed);
+    while(frame + 1 < target) render_frame();
+    return true;
+}
+
+bool kal_render_frames(
+    uint8_t s,
+    uint8_t density,
+    uint32_t seed,
+    uint32_t first_frame,
+    uint32_t count,
+    uint8_t* out) {
+    if(!arena_base || s >= STYLE_COUNT || density > KAL_DENSITY_MAX || first_frame == 0) {
+        return false;
+    }
+
+    bool same_run = run_pristine && s == style && density == dot_threshold && seed == run_seed;
+    if(!same_run || frame >= first_frame) kal_start(s, density, seed);
+    if(slice_active) render_frame(); // finish a frame left half done
+    if(frame + 1 < first_frame) kal_seek(first_frame);
+    for(uint32_t i = 0; i < count; i++) {
+        render_frame();
+        memcpy(out + i * KAL_FRAME_BYTES, fb, KAL_FRAME_BYTES);
+    }
+    return true;
+}
+
+void kal_cache_stats(KalCacheStats* stats) {
+    *stats = cache_stats;
+}
+
+void kal_set_table_store(KalTableLoad load, KalTableSave save, void* ctx) {
+    table_load = load;
+    table_save = save;
+    table_ctx = ctx;
+}
+
+void kal_set_budget(KalBudgetCallback callback, void* ctx) {
+    budget_callback = callback;
+    budget_ctx = ctx;
+}
+
+void kal_set_yield(KalYieldCallback callback, void* ctx) {
+    yield_callback = callback;
+    yield_ctx = ctx;
+}
+
+uint8_t kal_filter_count(void) {
+    return COUNT_OF(filter_presets);
+}
+
+const uint8_t* kal_filter_apply(uint8_t preset) {
+    if(preset >= COUNT_OF(filter_presets)) preset = 0;
+    return filter_apply(&filter_presets[preset]);
+}
+
+void kal_pack_mask_row(const uint8_t* mask, uint8_t* out, uint16_t n, KalPackOrder order) {
+    pack_mask_row(mask, out, n, order);
+}
+
+void kal_pack_threshold_row(
+    const uint8_t* value,
+    const uint8_t* threshold,
+    uint8_t* out,
+    uint16_t n,
+    KalPackOrder order) {
+    pack_threshold_row(value, threshold, out, n, order);
+}
+
+void kal_pack_reverse_row(const uint8_t* in, uint8_t* out, uint16_t n) {
+    for(uint16_t i = 0; i < n; i++) out[i] = rev8(in[i]);
+}
+
+void kal_ifft(int32_t (*data)[2], uint8_t log2n) {
+    if(log2n <= 6) fft_inverse(data, log2n);
+}
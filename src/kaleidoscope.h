@@ -0,0 +1,197 @@
+#pragma once
+
+//--------------------------------------------------------------------------------
+// Kaleidoscope pattern engine
+//
+// Renders the kaleidoscope styles into packed 1bpp frames, with no dependency
+// on the Flipper firmware, so the same code drives the app and host tools.
+// Frames are KAL_STRIDE bytes per row with the leftmost pixel in the least
+// significant bit, the layout canvas_draw_xbm expects.
+//
+// The engine keeps a single run (style, density, seed and simulation state)
+// in module state and a caller-provided arena, so it is not reentrant;
+// callers on several threads must serialise access. A run is deterministic:
+// the same style, density and seed always produce the same frames, unless the
+// run was changed by kal_set_density or kal_poke, or a budget callback limits
+// the work per frame.
+//--------------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KAL_WIDTH 128
+#define KAL_HEIGHT 64
+#define KAL_STRIDE (KAL_WIDTH / 8)
+#define KAL_FRAME_BYTES (KAL_STRIDE * KAL_HEIGHT)
+
+#define KAL_STYLE_COUNT 18
+#define KAL_DENSITY_MAX 100
+
+// Bytes of the arena set aside for cached tables (see kal_cache_stats). The
+// build fails if it cannot hold the polar and sine tables at once (about
+// 6.2 KiB); without room for them the spiral and sunburst render blank.
+#ifndef KAL_CACHE_BUDGET
+#define KAL_CACHE_BUDGET (7 * 1024)
+#endif
+
+typedef enum {
+    KalPackLsbFirst, // XBM / canvas_draw_xbm order
+    KalPackMsbFirst, // PBM order
+} KalPackOrder;
+
+typedef struct {
+    uint32_t budget; // bytes
+    uint32_t used; // bytes held by cached tables
+    uint32_t tables;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t loads; // misses served by the table store
+    uint32_t evictions;
+} KalCacheStats;
+
+// Identifies a cached table: the style, density and parameter hash it was
+// generated for (style 0xFF for tables shared between styles). The hash also
+// covers the generator's parameters and version. No padding, so it can be
+// compared with memcmp.
+typedef struct {
+    uint32_t hash;
+    uint16_t size; // bytes
+    uint8_t style;
+    uint8_t density;
+} KalTableKey;
+
+// Table store: load fills table (key->size bytes) from a copy saved earlier
+// and returns true, or returns false if it has none that matches key; save
+// is handed every table the engine had to generate itself
+typedef bool (*KalTableLoad)(const KalTableKey* key, void* table, void* ctx);
+typedef void (*KalTableSave)(const KalTableKey* key, const void* table, void* ctx);
+
+// Asked by time-budgeted styles whether another iteration of work fits into
+// the current frame. Called with iterations == 0 when a frame's work starts
+// (the return value is ignored), then after every iteration. Without a
+// callback such styles run a fixed number of iterations per frame.
+typedef bool (*KalBudgetCallback)(uint32_t budget_us, uint8_t iterations, void* ctx);
+
+// Asked by kal_render_slice after every row or simulation step of the frame
+// in progress whether to stop there for now
+typedef bool (*KalYieldCallback)(void* ctx);
+
+// Bytes of working memory the engine needs: its shared buffers plus those of
+// the hungriest style
+size_t kal_arena_size(void);
+
+// Hand the engine its working memory, at least kal_arena_size() bytes aligned
+// to 8, before calling anything below. The engine allocates nothing else, so
+// freeing the block (after the last call) releases everything. Returns false
+// if the block is too small or misaligned.
+bool kal_init(void* arena, size_t size);
+
+// Arena bytes in use by the current run, and the most ever in use
+size_t kal_arena_used(void);
+size_t kal_arena_peak(void);
+
+// Start a fresh run of style at density (0..KAL_DENSITY_MAX)
+void kal_start(uint8_t style, uint8_t density, uint32_t seed);
+
+// Change the density of the current run from the next frame on. Call it
+// between frames, not while kal_render_slice is halfway through one.
+void kal_set_density(uint8_t density);
+
+// Interact with the current style on the next frame (e.g. drop a ripple).
+// Like kal_set_density, call it between frames.
+void kal_poke(void);
+
+// Render the next frame of the current run (or finish the one in progress).
+// The returned frame is owned by the engine and valid until the next call
+// into it.
+const uint8_t* kal_next_frame(void);
+
+// Render the next frame of the current run in slices: each call continues
+// where the last one stopped, until the yield callback asks it to stop.
+// Returns true once the frame is complete. Slicing does not change what is
+// rendered, except that time-budgeted styles keep their budget running
+// while the frame is yielded.
+bool kal_render_slice(void);
+
+// The last complete frame, owned by the engine like kal_next_frame's
+const uint8_t* kal_frame(void);
+
+uint8_t kal_style(void); // 0xFF before the first kal_start
+uint8_t kal_density(void);
+// Frames of a run are numbered from 1, here and in kal_seek and
+// kal_render_frames; this is the number of the last complete one (0 before
+// the first)
+uint32_t kal_frames_rendered(void);
+
+// Whether style renders any frame from its number alone. Seeking it costs a
+// single frame; the others are simulations and cannot skip frames.
+bool kal_seekable(uint8_t style);
+
+// Make frame (1 for the first) the next one the current run renders, in
+// either direction. Seekable styles jump there, giving the same frame that
+// playback would. Simulations render every frame up to it, starting over
+// from the run's seed when going back, so a seek costs them as much as the
+// frames in between, and they forget any kal_poke. Returns false before
+// kal_start or for frame 0.
+bool kal_seek(uint32_t frame);
+
+// Render frames first_frame .. first_frame + count - 1 (1 for the first) of
+// the run given by (style, density, seed) into out, which holds
+// count * KAL_FRAME_BYTES bytes. Continues the current run when possible, so
+// consecutive batches only render each frame once, and seeks to first_frame
+// otherwise. Returns false for an invalid style or density, for frame 0, or
+// before kal_init.
+bool kal_render_frames(
+    uint8_t style,
+    uint8_t density,
+    uint32_t seed,
+    uint32_t first_frame,
+    uint32_t count,
+    uint8_t* out);
+
+void kal_set_budget(KalBudgetCallback callback, void* ctx);
+void kal_set_yield(KalYieldCallback callback, void* ctx);
+
+// Counters of the table cache, which keeps precomputed tables across runs so
+// that revisiting a style does not rebuild them
+void kal_cache_stats(KalCacheStats* stats);
+
+// Keep generated tables somewhere that outlives the engine (e.g. a file per
+// table), so that later runs load them instead of generating them again.
+// A table whose parameters change gets a new hash, so stale copies are never
+// asked for again; other changes to a generator must bump KAL_TABLE_VERSION
+// in kaleidoscope.c by hand.
+void kal_set_table_store(KalTableLoad load, KalTableSave save, void* ctx);
+
+// Post-processing filter presets (0 is off), applied to the last complete
+// frame. The result is owned by the engine, like the frame itself.
+uint8_t kal_filter_count(void);
+const uint8_t* kal_filter_apply(uint8_t preset);
+
+// Pack n pixels (a multiple of 8) of zero / nonzero bytes into n / 8 bytes
+void kal_pack_mask_row(const uint8_t* mask, uint8_t* out, uint16_t n, KalPackOrder order);
+
+// Pack (value[i] >= threshold[i]) for n pixels (a multiple of 8)
+void kal_pack_threshold_row(
+    const uint8_t* value,
+    const uint8_t* threshold,
+    uint8_t* out,
+    uint16_t n,
+    KalPackOrder order);
+
+// Convert n packed bytes between LSB-first and MSB-first order
+void kal_pack_reverse_row(const uint8_t* in, uint8_t* out, uint16_t n);
+
+// Inverse FFT in place of 2^log2n complex values (real, imaginary), for
+// log2n up to 6, without the 1 / n; the spectral style's transform.
+// Magnitudes must stay below 2^16.
+void kal_ifft(int32_t (*data)[2], uint8_t log2n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,12 +1,24 @@
 #include <furi.h>
+#include <furi_hal.h>
 #include <gui/gui.h>
 #include <input/input.h>
+#include <storage/storage.h>
 #include <stdlib.h>
-#include <math.h>    // for sqrtf, sinf
+#include <string.h>  // for memset
 
-// Screen dimensions
-#define W 128
-#define H 64
+#include "kaleidoscope.h"
+
+#define TAG "Kaleidoscope"
+
+// Working memory for the pattern engine, allocated once at start
+#define ARENA_BUDGET (32 * 1024)
+
+// A frame starts every FRAME_MS, or at once after input, and is rendered on
+// the app thread in slices of about SLICE_US, so that the GUI, input and
+// exports get the CPU between slices however heavy the style
+#define FRAME_MS 100
+#define SLICE_US 2000
+#define FRAME_FLAG (1UL << 0) // set by input to start the next frame early
 
 // Global running flag must be declared before input_callback
 static bool app_running = true;
@@ -14,211 +26,271 @@ static bool app_running = true;
 // Minimum and maximum dot-density thresholds (0–100)
 static uint8_t dot_threshold = 50; // start at 50% chance per pixel
 
-// Four “styles” for kaleidoscope, but reordered per your request:
-// 0 = old-style2  (rotated-line “star” → originally Vis 3)
-// 1 = old-style1  (concentric-arcs → originally Vis 2, unchanged)
-// 2 = old-style3  (quadrant-noise → originally Vis 4)
-// 3 = old-style0  (random mirrored dots → originally Vis 1)
+// Selected style, handed to the engine on the next frame (see kaleidoscope.c
+// for the list)
 static uint8_t style = 0;
 
-// Frame counter for animation
-static uint32_t frame = 0;
+// Set by an OK press and passed on to the engine with the next frame
+static bool ok_pending = false;
 
-// Clamp helper
-static uint8_t clamp_u8(uint8_t v, uint8_t lo, uint8_t hi) {
-    if(v < lo) return lo;
-    if(v > hi) return hi;
-    return v;
-}
+// Playback direction, set by a long press on Left (backwards) or Right
+// (forwards), and whether the key is still held, which scrubs
+// SCRUB_SPEED times as fast. Simulations cannot go back, so they pause
+// while playing backwards.
+#define SCRUB_SPEED 8
+static int8_t play_direction = 1;
+static bool scrubbing = false;
+
+// Selected post-processing preset, remembered separately for every style
+static uint8_t style_filter[KAL_STYLE_COUNT];
 
 //--------------------------------------------------------------------------------
-// OLD-STYLE0 → is now at index 3: Random mirrored dots (static until arrow redraw)
+// Duty-cycle cap (hold Up): keeps the share of wall-clock time the app spends
+// rendering and drawing under DUTY_CAP_PERCENT, so the CPU sleeps most of the
+// time on battery-powered displays
+//
+// The work of every shown frame is measured with the cycle counter and
+// smoothed per style. Frames of a style that costs more than its share of
+// FRAME_MS come less often (lower frame rate), and time-budgeted styles get
+// a smaller budget (lower quality). The app thread sleeps in between, and
+// input no longer starts frames early. The duty cycle achieved over the last
+// window is shown in the bottom left corner and logged.
 //--------------------------------------------------------------------------------
-static void render_style0(Canvas* canvas) {
-    canvas_clear(canvas);
-    for(uint8_t x = 0; x < W/2; x++) {
-        for(uint8_t y = 0; y < H; y++) {
-            if((rand() % 100) < dot_threshold) {
-                canvas_draw_dot(canvas, x, y);
-                canvas_draw_dot(canvas, W - 1 - x, y);
-            }
-        }
-    }
+#define DUTY_CAP_PERCENT 20
+#define DUTY_BUDGET_US (FRAME_MS * 1000 * DUTY_CAP_PERCENT / 100 / 2) // half the share
+#define DUTY_WINDOW_MS 1000
+#define DUTY_LOG_WINDOWS 10 // log every 10 s
+
+static bool duty_capped = false;
+static uint32_t style_busy_us[KAL_STYLE_COUNT]; // smoothed work per shown frame
+static volatile uint32_t draw_cycles = 0; // total, counted by the draw callback
+static uint32_t draw_seen = 0; // draw_cycles already accounted for
+static uint32_t duty_busy = 0; // cycles of work in the current window
+static uint32_t duty_window_start = 0;
+static uint16_t duty_permille = 0; // of the last window
+static uint8_t duty_windows = 0;
+
+// Time between frame starts for the current style
+static uint32_t duty_frame_ms(void) {
+    uint8_t shown = kal_style();
+    if(!duty_capped || shown >= KAL_STYLE_COUNT) return FRAME_MS;
+    uint32_t ms = style_busy_us[shown] / (10 * DUTY_CAP_PERCENT); // busy / cap
+    return ms > FRAME_MS ? ms : FRAME_MS;
 }
 
-//--------------------------------------------------------------------------------
-// OLD-STYLE1 → is still at index 1: Animated concentric-arc segments
-//--------------------------------------------------------------------------------
-static void render_style1(Canvas* canvas) {
-    canvas_clear(canvas);
-    int cx = W/2;
-    int cy = H/2;
-    uint8_t step = clamp_u8(dot_threshold / 10 + 2, 2, 10);
-    int offset = frame % step;
-    for(int r = offset; r < cy; r += step) {
-        for(int dy = -r; dy <= r; dy++) {
-            int inside = (r * r) - (dy * dy);
-            if(inside < 0) continue;
-            float xf = sqrtf((float)inside);
-            int dx = (int)(xf + 0.5f);
-            canvas_draw_dot(canvas, cx - dx, cy + dy);
-            canvas_draw_dot(canvas, cx + dx, cy + dy);
-        }
+// Account for a shown frame that took cycles on the app thread
+static void duty_frame_done(uint32_t cycles) {
+    uint32_t draw = draw_cycles;
+    cycles += draw - draw_seen; // the draw callback's share (of the last frame)
+    draw_seen = draw;
+    duty_busy += cycles;
+    uint8_t shown = kal_style();
+    if(shown < KAL_STYLE_COUNT) {
+        uint32_t us = cycles / furi_hal_cortex_instructions_per_microsecond();
+        style_busy_us[shown] = (style_busy_us[shown] * 3 + us) / 4;
     }
 }
 
-//--------------------------------------------------------------------------------
-// OLD-STYLE2 → is now at index 0: Animated rotated-line “star” pattern
-//--------------------------------------------------------------------------------
-static void render_style2(Canvas* canvas) {
-    canvas_clear(canvas);
-    int cx = W/2;
-    int cy = H/2;
-    uint8_t spokes = clamp_u8(dot_threshold / 10 + 2, 2, 16);
-    float base_angle = (frame * 0.05f);
-    float angle_step = 3.14159f / spokes;
-    for(uint8_t s = 0; s < spokes; s++) {
-        float angle = base_angle + (s * angle_step);
-        for(int len = 0; len < (W/2); len++) {
-            int x_off = (int)(cosf(angle) * len);
-            int y_off = (int)(sinf(angle) * len);
-            canvas_draw_dot(canvas, cx + x_off, cy + y_off);
-            canvas_draw_dot(canvas, cx - x_off, cy + y_off);
-        }
-        float perp = angle + 3.14159f / 2.0f;
-        for(int len = 0; len < (H/2); len++) {
-            int x_off = (int)(cosf(perp) * len);
-            int y_off = (int)(sinf(perp) * len);
-            canvas_draw_dot(canvas, cx + x_off, cy + y_off);
-            canvas_draw_dot(canvas, cx - x_off, cy + y_off);
-        }
+// Close the measuring window once it is DUTY_WINDOW_MS long
+static void duty_window_update(void) {
+    uint32_t wall = DWT->CYCCNT - duty_window_start;
+    if(wall < DUTY_WINDOW_MS * 1000 * furi_hal_cortex_instructions_per_microsecond()) return;
+    duty_permille = (uint64_t)duty_busy * 1000 / wall;
+    duty_busy = 0;
+    duty_window_start = DWT->CYCCNT;
+    if(duty_capped && ++duty_windows % DUTY_LOG_WINDOWS == 0) {
+        FURI_LOG_I(
+            TAG,
+            "duty cycle %u.%u%% (cap %u%%), style %u every %lu ms",
+            duty_permille / 10,
+            duty_permille % 10,
+            DUTY_CAP_PERCENT,
+            kal_style(),
+            duty_frame_ms());
     }
 }
 
-//--------------------------------------------------------------------------------
-// OLD-STYLE3 → is now at index 2: Animated quadrant-based noise (gradient)
-//--------------------------------------------------------------------------------
-static void render_style3(Canvas* canvas) {
-    canvas_clear(canvas);
-    int cx = W/2;
-    int cy = H/2;
-    int maxDist = cx + cy;
-    srand(furi_get_tick() ^ frame);
-    for(int x = 0; x < W; x++) {
-        for(int y = 0; y < H; y++) {
-            int dx = abs(x - cx);
-            int dy = abs(y - cy);
-            int dist = dx + dy;
-            int localThresh = dot_threshold - (dist * dot_threshold / maxDist);
-            if(localThresh < 0) localThresh = 0;
-            if((rand() % 100) < (uint8_t)localThresh) {
-                canvas_draw_dot(canvas, x, y);
-            }
-        }
-    }
+static void duty_draw(Canvas* canvas) {
+    char line[12];
+    snprintf(line, sizeof(line), "%u.%u%%", duty_permille / 10, duty_permille % 10);
+    canvas_set_font(canvas, FontSecondary);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_draw_box(canvas, 0, KAL_HEIGHT - 9, canvas_string_width(canvas, line) + 2, 9);
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_str(canvas, 1, KAL_HEIGHT - 1, line);
 }
 
-//--------------------------------------------------------------------------------
-// NEW-STYLE4: Spiral swirl
-//--------------------------------------------------------------------------------
-static void render_style4(Canvas* canvas) {
-    canvas_clear(canvas);
-    int cx = W/2, cy = H/2;
+// Time-budgeted styles get as long per frame as they ask for, within the
+// duty-cycle cap
+static FuriHalCortexTimer budget_timer;
+
+static bool budget_callback(uint32_t budget_us, uint8_t iterations, void* ctx) {
+    FuriHalCortexTimer* timer = ctx;
+    if(duty_capped && budget_us > DUTY_BUDGET_US) budget_us = DUTY_BUDGET_US;
+    if(iterations == 0) *timer = furi_hal_cortex_timer_get(budget_us);
+    return !furi_hal_cortex_timer_is_expired(*timer);
+}
 
-    for(int y = 0; y < H; y++) {
-        for(int x = 0; x < W; x++) {
-            float dx = (float)(x - cx);
-            float dy = (float)(y - cy);
-            float r = sqrtf(dx*dx + dy*dy);
-            float angle = atan2f(dy, dx);
+// Slices end when their timer runs out
+static FuriHalCortexTimer slice_timer;
 
-            float val = sinf(r*0.3f + angle*6.0f - frame*0.1f);
-            if(val > 0.8f) canvas_draw_dot(canvas, x, y);
-        }
-    }
+static bool yield_callback(void* ctx) {
+    FuriHalCortexTimer* timer = ctx;
+    return furi_hal_cortex_timer_is_expired(*timer);
 }
 
+static FuriThreadId app_thread;
+
 //--------------------------------------------------------------------------------
-// NEW-STYLE5: Animated checkerboard wave
+// Table store: the engine's generated tables, kept on the SD card so that the
+// next launch reads them back instead of computing them again
+//
+// One file per table, named after its key, holding a header with the whole
+// key and a checksum, then the table, so it comes back in one sequential
+// read. A file for another key or damaged is ignored, and replaced by the
+// fresh table.
 //--------------------------------------------------------------------------------
-static void render_style5(Canvas* canvas) {
-    canvas_clear(canvas);
+#define TABLE_DIR APP_DATA_PATH("tables")
+#define TABLE_MAGIC 0x3242544BUL // "KTB2"
+
+typedef struct {
+    uint32_t magic;
+    KalTableKey key;
+    uint32_t checksum;
+} TableHeader;
+
+// FNV-1a
+static uint32_t table_checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261UL;
+    for(size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619UL;
+    return hash;
+}
+
+static void table_path(char* path, size_t size, const KalTableKey* key) {
+    snprintf(path, size, TABLE_DIR "/%02x%02x%08lx.bin", key->style, key->density, key->hash);
+}
 
-    for(int y = 0; y < H; y++) {
-        for(int x = 0; x < W; x++) {
-            float nx = x * 0.1f + frame*0.05f;
-            float ny = y * 0.1f;
+static bool table_load(const KalTableKey* key, void* table, void* ctx) {
+    Storage* storage = ctx;
+    char path[64];
+    table_path(path, sizeof(path), key);
+
+    File* file = storage_file_alloc(storage);
+    TableHeader header;
+    bool ok = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+              storage_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+              header.magic == TABLE_MAGIC && memcmp(&header.key, key, sizeof(*key)) == 0 &&
+              storage_file_read(file, table, key->size) == key->size &&
+              table_checksum(table, key->size) == header.checksum;
+    storage_file_close(file);
+    storage_file_free(file);
+    return ok;
+}
 
-            int checker = (((int)floorf(nx) + (int)floorf(ny)) & 1);
-            if(checker) {
-                float wave = sinf(nx*1.5f) * cosf(ny*1.5f);
-                if(wave > 0.3f) canvas_draw_dot(canvas, x, y);
-            }
-        }
+static void table_save(const KalTableKey* key, const void* table, void* ctx) {
+    Storage* storage = ctx;
+    char path[64];
+    table_path(path, sizeof(path), key);
+
+    File* file = storage_file_alloc(storage);
+    TableHeader header = {TABLE_MAGIC, *key, table_checksum(table, key->size)};
+    bool ok = storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(file, &header, sizeof(header)) == sizeof(header) &&
+              storage_file_write(file, table, key->size) == key->size;
+    storage_file_close(file);
+    storage_file_free(file);
+    if(!ok) {
+        FURI_LOG_W(TAG, "cannot save %s", path);
+        storage_common_remove(storage, path);
     }
 }
 
 //--------------------------------------------------------------------------------
-// NEW-STYLE6: Pulsating radial sunburst
+// General render switcher
 //--------------------------------------------------------------------------------
-static void render_style6(Canvas* canvas) {
-    canvas_clear(canvas);
-    int cx = W/2, cy = H/2;
-
-    // Rays count depends on density (between 6 and 24)
-    int rays = 6 + (dot_threshold / 5); 
-    float speed = frame * 0.08f;
+// Bring the engine in line with the controls before the next frame starts.
+// Returns false when there is no frame to render, i.e. when a simulation is
+// played backwards.
+static bool start_frame(void) {
+    if(style != kal_style()) {
+        kal_start(style, dot_threshold, furi_get_tick());
+        FURI_LOG_D(TAG, "style %u uses %u arena bytes", style, (unsigned)kal_arena_used());
+    } else {
+        kal_set_density(dot_threshold);
+    }
+    if(ok_pending) kal_poke();
+    ok_pending = false;
 
-    for(int y = 0; y < H; y++) {
-        for(int x = 0; x < W; x++) {
-            float dx = (float)(x - cx);
-            float dy = (float)(y - cy);
-            float r = sqrtf(dx*dx + dy*dy);
-            float angle = atan2f(dy, dx);
+    uint32_t now = kal_frames_rendered();
+    if(now == 0 || (play_direction > 0 && !scrubbing)) return true;
+    if(!kal_seekable(style)) return play_direction > 0; // the loop fast-forwards
 
-            // Angular ray pattern
-            float ray_val = cosf(angle * rays + speed);
+    int32_t target = (int32_t)now + play_direction * (scrubbing ? SCRUB_SPEED : 1);
+    kal_seek(target < 1 ? 1 : target);
+    return true;
+}
 
-            // Radial pulsation
-            float ring_val = sinf(r * 0.25f - speed * 0.7f);
+// Copy of the last frame drawn, shown again while the engine is busy
+static uint8_t shown_frame[KAL_FRAME_BYTES];
 
-            // Combine
-            if(ray_val * ring_val > 0.65f) {
-                canvas_draw_dot(canvas, x, y);
-            }
-        }
-    }
+static void draw_frame(Canvas* canvas, const uint8_t* frame) {
+    canvas_clear(canvas);
+    canvas_draw_xbm(canvas, 0, 0, KAL_WIDTH, KAL_HEIGHT, frame);
+    if(duty_capped) duty_draw(canvas);
 }
 
-
-//--------------------------------------------------------------------------------
-// General render switcher (reordered)
-//--------------------------------------------------------------------------------
+// Show the last complete frame
 static void render_pattern(Canvas* canvas) {
-    frame++;
-    switch(style) {
-        case 0: render_style2(canvas); break; // rotated star
-        case 1: render_style1(canvas); break; // arcs
-        case 2: render_style3(canvas); break; // noise
-        case 3: render_style0(canvas); break; // mirrored dots
-        case 4: render_style4(canvas); break; // spiral swirl
-        case 5: render_style5(canvas); break; // checkerboard
-        case 6: render_style6(canvas); break; // sunburst
-        default: render_style0(canvas); break;
-    }
+    // Styles may keep state in their frame, so post-processing writes to its
+    // own buffer instead of filtering the frame in place
+    uint8_t shown = kal_style();
+    const uint8_t* out = kal_filter_apply(shown < KAL_STYLE_COUNT ? style_filter[shown] : 0);
+    memcpy(shown_frame, out, sizeof(shown_frame));
+    draw_frame(canvas, shown_frame);
 }
 
-
+// Held by whoever drives the engine: the main loop while it renders a slice,
+// or the draw callback while it shows the last frame
+static FuriMutex* render_mutex;
 
 // ViewPort draw callback (ctx unused here)
 static void view_callback(Canvas* canvas, void* ctx) {
     (void)ctx;
+    // A slice holds the engine for a couple of milliseconds, unless it
+    // overruns (say on a table cache miss), in which case the last frame is
+    // shown again
+    if(furi_mutex_acquire(render_mutex, furi_ms_to_ticks(10)) != FuriStatusOk) {
+        draw_frame(canvas, shown_frame);
+        return;
+    }
+    uint32_t start = DWT->CYCCNT;
     render_pattern(canvas);
+    furi_mutex_release(render_mutex);
+    draw_cycles += DWT->CYCCNT - start;
 }
 
 // ViewPort input callback (arrow keys + Back, plus immediate redraw)
 static void input_callback(InputEvent* event, void* ctx) {
     ViewPort* vp = ctx;
+    if(event->type == InputTypeLong && event->key == InputKeyUp) {
+        duty_capped = !duty_capped;
+        FURI_LOG_I(TAG, "duty-cycle cap %s", duty_capped ? "on" : "off");
+        view_port_update(vp);
+        return;
+    }
+    if(event->type == InputTypeLong && event->key == InputKeyOk) {
+        style_filter[style] = (style_filter[style] + 1) % kal_filter_count();
+        view_port_update(vp);
+        return;
+    }
+    if(event->key == InputKeyLeft || event->key == InputKeyRight) {
+        if(event->type == InputTypeLong || event->type == InputTypeRepeat) {
+            play_direction = (event->key == InputKeyLeft) ? -1 : 1;
+            scrubbing = true;
+            return;
+        }
+        if(event->type == InputTypeRelease) scrubbing = false;
+    }
     if(event->type != InputTypeShort) return;
 
     bool do_redraw = false;
@@ -226,36 +298,240 @@ static void input_callback(InputEvent* event, void* ctx) {
     switch(event->key) {
         case InputKeyBack:
             app_running = false;
+            furi_thread_flags_set(app_thread, FRAME_FLAG);
             return;
         case InputKeyLeft:
-            style = (style == 0) ? 6 : (style - 1);
+            style = (style == 0) ? (KAL_STYLE_COUNT - 1) : (style - 1);
+            play_direction = 1; // a new style starts at frame 1, so it plays forwards
+            scrubbing = false;
             do_redraw = true;
             break;
         case InputKeyRight:
-            style = (style == 6) ? 0 : (style + 1);
+            style = (style == KAL_STYLE_COUNT - 1) ? 0 : (style + 1);
+            play_direction = 1;
+            scrubbing = false;
             do_redraw = true;
             break;
         case InputKeyUp:
-            dot_threshold = clamp_u8(dot_threshold + 10, 0, 100);
+            dot_threshold = (dot_threshold > 90) ? 100 : (dot_threshold + 10);
             do_redraw = true;
             break;
         case InputKeyDown:
             dot_threshold = (dot_threshold < 10) ? 0 : (dot_threshold - 10);
             do_redraw = true;
             break;
+        case InputKeyOk:
+            ok_pending = true;
+            do_redraw = true;
+            break;
         default:
             break;
     }
 
     if(do_redraw) {
-        view_port_update(vp);
+        furi_thread_flags_set(app_thread, FRAME_FLAG);
+    }
+}
+
+#ifdef KALEIDOSCOPE_BENCHMARK
+//--------------------------------------------------------------------------------
+// Benchmarks, logged at startup. Need the DWT cycle counter, which the
+// firmware enables at boot.
+//
+// Packing: cycles per full frame for the per-pixel loop the styles used to
+// run versus pack_mask_row / pack_threshold_row.
+//
+// FFT: cycles per inverse FFT of the sizes the spectral style runs, and for
+// the 33 column and 16 row transforms of one of its frames.
+//
+// Styles: for every style and density, the time per frame plus how much of
+// the screen is lit, how much changes from frame to frame and after how many
+// frames the animation repeats. Lit and changed pixels are popcounts over the
+// packed rows; the period compares a hash of each frame with earlier ones.
+// Low change ratios favour delta presentation, short periods loop caching.
+// Seekable styles are also checked to render the same frames when seeked to.
+//--------------------------------------------------------------------------------
+static uint8_t bench_values[KAL_WIDTH];
+static uint8_t bench_thresholds[4][KAL_WIDTH];
+static uint8_t bench_out[KAL_FRAME_BYTES];
+
+static uint32_t bench_naive(void) {
+    uint32_t start = DWT->CYCCNT;
+    for(uint8_t y = 0; y < KAL_HEIGHT; y++) {
+        uint8_t* out = &bench_out[y * KAL_STRIDE];
+        for(uint8_t bx = 0; bx < KAL_STRIDE; bx++) {
+            uint8_t bits = 0;
+            for(uint8_t i = 0; i < 8; i++) {
+                uint8_t x = bx * 8 + i;
+                bits |= (uint8_t)(bench_values[x] >= bench_thresholds[y & 3][x]) << i;
+            }
+            out[bx] = bits;
+        }
     }
+    return DWT->CYCCNT - start;
 }
 
+static uint32_t bench_mask(void) {
+    uint32_t start = DWT->CYCCNT;
+    for(uint8_t y = 0; y < KAL_HEIGHT; y++) {
+        kal_pack_mask_row(bench_values, &bench_out[y * KAL_STRIDE], KAL_WIDTH, KalPackLsbFirst);
+    }
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t bench_threshold(void) {
+    uint32_t start = DWT->CYCCNT;
+    for(uint8_t y = 0; y < KAL_HEIGHT; y++) {
+        kal_pack_threshold_row(
+            bench_values, bench_thresholds[y & 3], &bench_out[y * KAL_STRIDE], KAL_WIDTH, KalPackLsbFirst);
+    }
+    return DWT->CYCCNT - start;
+}
+
+static int32_t bench_fft_data[KAL_WIDTH / 2][2];
+
+static uint32_t bench_fft(uint8_t log2n) {
+    for(uint8_t i = 0; i < (1 << log2n); i++) {
+        bench_fft_data[i][0] = rand() % 512 - 256;
+        bench_fft_data[i][1] = rand() % 512 - 256;
+    }
+    uint32_t start = DWT->CYCCNT;
+    kal_ifft(bench_fft_data, log2n);
+    return DWT->CYCCNT - start;
+}
+
+static void bench_log(const char* name, uint32_t cycles) {
+    // Hundredths of a percent of one 100ms frame
+    uint32_t share = cycles / (furi_hal_cortex_instructions_per_microsecond() * 10);
+    FURI_LOG_I(TAG, "%s: %lu cycles (%lu.%02lu%% of frame)", name, cycles, share / 100, share % 100);
+}
+
+#define METRICS_FRAMES 128 // frames per style and density
+#define METRICS_SEED 0xBE7C
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t lit; // pixels, summed over all frames
+    uint32_t changed; // pixels, summed over all frames after the first
+    uint16_t period; // 0 when none was seen
+} StyleMetrics;
+
+#define METRICS_WORDS (KAL_FRAME_BYTES / 4)
+
+static uint32_t metrics_prev[METRICS_WORDS];
+static uint32_t metrics_hash[METRICS_FRAMES];
+
+// Count lit and changed pixels of a frame against the previous one, then
+// keep it as the new previous frame; returns an FNV-1a hash of the frame
+static uint32_t metrics_frame(StyleMetrics* m, const uint8_t* frame) {
+    uint32_t hash = 2166136261UL;
+    for(uint16_t i = 0; i < METRICS_WORDS; i++) {
+        uint32_t w;
+        memcpy(&w, &frame[i * 4], sizeof(w));
+        m->lit += __builtin_popcount(w);
+        m->changed += __builtin_popcount(w ^ metrics_prev[i]);
+        metrics_prev[i] = w;
+        hash = (hash ^ w) * 16777619UL;
+    }
+    return hash;
+}
+
+// Smallest lag at which the second half of the run repeats itself, so that
+// the start-up transient of stateful styles does not hide a loop
+static uint16_t metrics_period(void) {
+    for(uint16_t p = 1; p <= METRICS_FRAMES / 2; p++) {
+        uint16_t i = METRICS_FRAMES / 2;
+        while(i < METRICS_FRAMES && metrics_hash[i] == metrics_hash[i - p]) i++;
+        if(i == METRICS_FRAMES) return p;
+    }
+    return 0;
+}
+
+// Seekable styles have to give every frame of the run just measured when
+// seeked to, here backwards from the last one
+static void bench_seek(uint8_t s, uint8_t density) {
+    StyleMetrics m = {0};
+    for(uint16_t f = METRICS_FRAMES; f-- > 0;) {
+        kal_seek(f + 1);
+        if(metrics_frame(&m, kal_next_frame()) != metrics_hash[f]) {
+            FURI_LOG_E(TAG, "style %u density %u: seeking to frame %u differs", s, density, f + 1);
+            return;
+        }
+    }
+}
+
+static void bench_style(uint8_t s, uint8_t density) {
+    StyleMetrics m = {0};
+    kal_start(s, density, METRICS_SEED);
+    memset(metrics_prev, 0, sizeof(metrics_prev));
+    for(uint16_t f = 0; f < METRICS_FRAMES; f++) {
+        uint32_t start = DWT->CYCCNT;
+        const uint8_t* frame = kal_next_frame();
+        m.cycles += DWT->CYCCNT - start;
+        metrics_hash[f] = metrics_frame(&m, frame);
+        if(f == 0) m.changed = 0; // the first frame has nothing to change from
+    }
+    m.period = metrics_period();
+
+    // Ratios in tenths of a percent
+    uint32_t lit = m.lit * 1000 / (KAL_WIDTH * KAL_HEIGHT * METRICS_FRAMES);
+    uint32_t changed = m.changed * 1000 / (KAL_WIDTH * KAL_HEIGHT * (METRICS_FRAMES - 1));
+    FURI_LOG_I(
+        TAG,
+        "style %u density %u: %lu us/frame, lit %lu.%lu%%, changed %lu.%lu%%, period %u, arena %u",
+        s,
+        density,
+        m.cycles / METRICS_FRAMES / furi_hal_cortex_instructions_per_microsecond(),
+        lit / 10,
+        lit % 10,
+        changed / 10,
+        changed % 10,
+        m.period,
+        (unsigned)kal_arena_used());
+    if(kal_seekable(s)) bench_seek(s, density);
+}
+
+static void bench_run(void) {
+    for(uint8_t x = 0; x < KAL_WIDTH; x++) {
+        bench_values[x] = rand() % 18;
+        for(uint8_t y = 0; y < 4; y++) bench_thresholds[y][x] = rand() % 16 + 1;
+    }
+
+    bench_log("pack naive", bench_naive());
+    bench_log("pack mask", bench_mask());
+    bench_log("pack threshold", bench_threshold());
+
+    uint32_t fft32 = bench_fft(5);
+    uint32_t fft64 = bench_fft(6);
+    bench_log("ifft 32", fft32);
+    bench_log("ifft 64", fft64);
+    bench_log("ifft 64x32", 33 * fft32 + 16 * fft64);
+
+    for(uint8_t s = 0; s < KAL_STYLE_COUNT; s++) {
+        for(uint8_t density = 0; density <= KAL_DENSITY_MAX; density += 10) {
+            bench_style(s, density);
+        }
+    }
+    kal_start(style, dot_threshold, furi_get_tick());
+}
+#endif
+
 // Entry point (must match entry_point in application.fam)
 int32_t digital_kaleidoscope_app(void* p) {
     (void)p;
-    srand(furi_get_tick());
+    void* arena = malloc(ARENA_BUDGET);
+    furi_check(kal_init(arena, ARENA_BUDGET));
+    FURI_LOG_I(TAG, "engine needs %u of %u arena bytes", (unsigned)kal_arena_size(), ARENA_BUDGET);
+    kal_set_budget(budget_callback, &budget_timer);
+    kal_set_yield(yield_callback, &slice_timer);
+    app_thread = furi_thread_get_current_id();
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_mkdir(storage, TABLE_DIR);
+    kal_set_table_store(table_load, table_save, storage);
+#ifdef KALEIDOSCOPE_BENCHMARK
+    bench_run();
+#endif
+    render_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
 
     // Set up GUI and ViewPort
     Gui* gui = furi_record_open(RECORD_GUI);
@@ -265,10 +541,47 @@ int32_t digital_kaleidoscope_app(void* p) {
     gui_add_view_port(gui, viewport, GuiLayerFullscreen);
     view_port_enabled_set(viewport, true);
 
-    // Main loop: update viewport for animation until Back is pressed
+    // Main loop: render a frame slice by slice, show it, then sleep until the
+    // next one is due or input asks for it, until Back is pressed
+    bool in_frame = false;
+    uint8_t skipped = 0; // frames a fast-forwarding simulation did not show
+    uint32_t frame_cycles = 0; // work on the frame (or frames) shown next
+    uint32_t frame_start = furi_get_tick();
+    duty_window_start = DWT->CYCCNT;
     while(app_running) {
-        furi_delay_ms(100);
+        furi_mutex_acquire(render_mutex, FuriWaitForever);
+        uint32_t start = DWT->CYCCNT;
+        bool render = in_frame || start_frame();
+        if(render) {
+            slice_timer = furi_hal_cortex_timer_get(SLICE_US);
+            in_frame = !kal_render_slice();
+        }
+        frame_cycles += DWT->CYCCNT - start;
+        furi_mutex_release(render_mutex);
+        if(in_frame) {
+            furi_thread_yield();
+            continue;
+        }
+
+        // Simulations scrub forwards by rendering the frames they skip
+        if(render && scrubbing && play_direction > 0 && !kal_seekable(style) &&
+           ++skipped < SCRUB_SPEED) {
+            continue;
+        }
+        skipped = 0;
+
+        duty_frame_done(frame_cycles);
+        frame_cycles = 0;
         view_port_update(viewport);
+        // Input cuts the sleep short, unless the duty cycle is capped
+        uint32_t period = furi_ms_to_ticks(duty_frame_ms());
+        uint32_t elapsed;
+        while(app_running && (elapsed = furi_get_tick() - frame_start) < period) {
+            furi_thread_flags_wait(FRAME_FLAG, FuriFlagWaitAny, period - elapsed);
+            if(!duty_capped) break;
+        }
+        duty_window_update();
+        frame_start = furi_get_tick();
     }
 
     // Clean up
@@ -276,6 +589,23 @@ int32_t digital_kaleidoscope_app(void* p) {
     view_port_enabled_set(viewport, false);
     view_port_free(viewport);
     furi_record_close(RECORD_GUI);
+    furi_mutex_free(render_mutex);
+    kal_set_table_store(NULL, NULL, NULL);
+    furi_record_close(RECORD_STORAGE);
+    FURI_LOG_I(TAG, "arena peak: %u bytes", (unsigned)kal_arena_peak());
+    KalCacheStats cache;
+    kal_cache_stats(&cache);
+    FURI_LOG_I(
+        TAG,
+        "table cache: %lu hits, %lu misses (%lu loaded from SD), %lu evictions",
+        cache.hits,
+        cache.misses,
+        cache.loads,
+        cache.evictions);
+    // The app thread renders, so its deepest call chains are the styles' and
+    // the table store's; stack_size in application.fam is sized from this
+    FURI_LOG_I(TAG, "stack: %lu bytes never used", furi_thread_get_stack_space(app_thread));
+    free(arena);
     return 0;
 }
 	
@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------
+// kal_bench: time the pattern engine on the host
+//
+//   kal_bench [-n frames] [-d density]
+//
+// Prints the time per inverse FFT of the sizes the spectral style runs (and
+// for the 33 column and 16 row transforms of one of its frames), then the
+// average time per frame of every style. The device benchmark (built with
+// KALEIDOSCOPE_BENCHMARK) logs the same figures in cycles, so the two can be
+// compared to spot where the Cortex-M4 differs from the host.
+//--------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/kaleidoscope.h"
+
+#define FFT_RUNS 100000
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Average microseconds per inverse FFT of 2^log2n points
+static double bench_fft(uint8_t log2n) {
+    static int32_t data[64][2];
+    double start = now_us();
+    for(uint32_t r = 0; r < FFT_RUNS; r++) {
+        // fresh input every run, so the values stay in range
+        for(uint8_t i = 0; i < (1 << log2n); i++) {
+            data[i][0] = (int32_t)((i * 37 + r) % 512) - 256;
+            data[i][1] = (int32_t)((i * 91 + r) % 512) - 256;
+        }
+        kal_ifft(data, log2n);
+    }
+    return (now_us() - start) / FFT_RUNS;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: kal_bench [-n frames] [-d density]\n");
+    exit(2);
+}
+
+static uint32_t parse_number(const char* s, uint32_t max) {
+    char* end;
+    errno = 0;
+    unsigned long v = strtoul(s, &end, 0);
+    if(errno || end == s || *end || v > max) usage();
+    return v;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 1000;
+    uint8_t density = 50;
+    int opt;
+    while((opt = getopt(argc, argv, "n:d:")) != -1) {
+        switch(opt) {
+            case 'n': frames = parse_number(optarg, UINT32_MAX); break;
+            case 'd': density = parse_number(optarg, KAL_DENSITY_MAX); break;
+            default: usage();
+        }
+    }
+    if(optind != argc || frames == 0) usage();
+
+    void* arena = aligned_alloc(8, (kal_arena_size() + 7) & ~(size_t)7);
+    if(!arena || !kal_init(arena, kal_arena_size())) {
+        fprintf(stderr, "kal_bench: no memory\n");
+        return 1;
+    }
+
+    double fft32 = bench_fft(5);
+    double fft64 = bench_fft(6);
+    printf("ifft 32: %.3f us\n", fft32);
+    printf("ifft 64: %.3f us\n", fft64);
+    printf("ifft 64x32: %.1f us\n", 33 * fft32 + 16 * fft64);
+
+    for(uint8_t s = 0; s < KAL_STYLE_COUNT; s++) {
+        kal_start(s, density, 1);
+        double start = now_us();
+        for(uint32_t f = 0; f < frames; f++) kal_next_frame();
+        printf("style %u density %u: %.1f us/frame\n", s, density, (now_us() - start) / frames);
+    }
+    free(arena);
+    return 0;
+}
@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------
+// kal_check: check on the host that seeking gives the frames playback does
+//
+//   kal_check [-n frames]
+//
+// For every seekable style at every density, plays the first frames of a run
+// and compares them with what the same run gives when seeked backwards from
+// the last frame, seeked forwards in growing steps, and rendered through
+// kal_render_frames in batches of 1 to BATCH_MAX frames. Prints every
+// mismatch and exits with status 1 if there was any, so it can run as a
+// build step.
+//--------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/kaleidoscope.h"
+
+#define SEED 0xC0FFEE
+#define BATCH_MAX 5
+
+static uint8_t (*played)[KAL_FRAME_BYTES]; // [frames], played[0] is frame 1
+static uint8_t batch[BATCH_MAX][KAL_FRAME_BYTES];
+static uint32_t failures = 0;
+
+static void check(const uint8_t* got, uint8_t s, uint8_t density, uint32_t f, const char* how) {
+    if(memcmp(got, played[f - 1], KAL_FRAME_BYTES) == 0) return;
+    printf("style %u density %u: frame %u differs when %s\n", s, density, (unsigned)f, how);
+    failures++;
+}
+
+static void check_run(uint8_t s, uint8_t density, uint32_t frames) {
+    kal_start(s, density, SEED);
+    for(uint32_t f = 1; f <= frames; f++) memcpy(played[f - 1], kal_next_frame(), KAL_FRAME_BYTES);
+
+    for(uint32_t f = frames; f >= 1; f--) {
+        kal_seek(f);
+        check(kal_next_frame(), s, density, f, "seeked backwards");
+    }
+    for(uint32_t f = 1, step = 1; f <= frames; f += step++) {
+        kal_seek(f);
+        check(kal_next_frame(), s, density, f, "seeked forwards");
+    }
+    // Batches of every size in turn, each continuing the last or skipping one
+    // frame, so they both resume the run and seek
+    uint32_t size = 1;
+    for(uint32_t f = 1; f + size - 1 <= frames; f += size + size % 2) {
+        kal_render_frames(s, density, SEED, f, size, batch[0]);
+        for(uint32_t i = 0; i < size; i++) check(batch[i], s, density, f + i, "rendered in batches");
+        size = size % BATCH_MAX + 1;
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: kal_check [-n frames]\n");
+    exit(2);
+}
+
+static uint32_t parse_number(const char* s, uint32_t max) {
+    char* end;
+    errno = 0;
+    unsigned long v = strtoul(s, &end, 0);
+    if(errno || end == s || *end || v > max) usage();
+    return v;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 40;
+    int opt;
+    while((opt = getopt(argc, argv, "n:")) != -1) {
+        switch(opt) {
+            case 'n': frames = parse_number(optarg, 100000); break;
+            default: usage();
+        }
+    }
+    if(optind != argc || frames == 0) usage();
+
+    void* arena = aligned_alloc(8, (kal_arena_size() + 7) & ~(size_t)7);
+    played = malloc((size_t)frames * KAL_FRAME_BYTES);
+    if(!arena || !played || !kal_init(arena, kal_arena_size())) {
+        fprintf(stderr, "kal_check: no memory\n");
+        return 1;
+    }
+
+    uint32_t runs = 0;
+    for(uint8_t s = 0; s < KAL_STYLE_COUNT; s++) {
+        if(!kal_seekable(s)) continue;
+        for(uint8_t density = 0; density <= KAL_DENSITY_MAX; density++) {
+            check_run(s, density, frames);
+            runs++;
+        }
+    }
+    printf("%u runs of %u frames, %u mismatches\n", (unsigned)runs, (unsigned)frames, (unsigned)failures);
+    free(played);
+    free(arena);
+    return failures ? 1 : 0;
+}
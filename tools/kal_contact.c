@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------
+// kal_contact: render every style at every density and a few points in time
+// on every core, and write the grid to stdout as one PBM image for reviewing
+// visual regressions
+//
+//   kal_contact [-j workers] > contact_sheet.pbm
+//
+// Each sheet row is one style at one density, each column a frame offset.
+// Cells are separated by black bars 8 pixels wide, which keeps every cell
+// byte aligned. The unit of work is a row (see kal_pool.h): a worker renders
+// its cells through kal_render_frames, which seeks straight to each offset
+// for styles that can and runs the others up to it, and sends them back.
+// The parent lays the cells out in the sheet, which it holds whole, and
+// writes it once every row is in. Runs are seeded and have no time budget,
+// so two sheets of the same build can be diffed.
+//--------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/kaleidoscope.h"
+#include "kal_pool.h"
+
+#define SHEET_GAP 8
+#define SHEET_DENSITIES 11 // 0, 10, ..., 100 as reached with Up/Down
+#define SHEET_SEED 0x5EED
+#define SHEET_CELL_W (KAL_WIDTH + SHEET_GAP)
+#define SHEET_CELL_H (KAL_HEIGHT + SHEET_GAP)
+
+static const uint32_t sheet_offsets[] = {1, 10, 40};
+
+#define SHEET_COLS (sizeof(sheet_offsets) / sizeof(sheet_offsets[0]))
+#define SHEET_ROWS (KAL_STYLE_COUNT * SHEET_DENSITIES)
+#define SHEET_W (SHEET_COLS * SHEET_CELL_W + SHEET_GAP)
+#define SHEET_H (SHEET_ROWS * SHEET_CELL_H + SHEET_GAP)
+#define SHEET_STRIDE (SHEET_W / 8)
+#define ROW_BYTES (SHEET_COLS * KAL_FRAME_BYTES) // the cells of a row, as sent
+
+static uint8_t* sheet; // SHEET_H rows of SHEET_STRIDE bytes
+
+// Worker: render the cells of a row
+static void work(int32_t row, int data) {
+    static uint8_t cells[ROW_BYTES];
+    uint8_t style = row / SHEET_DENSITIES;
+    uint8_t density = row % SHEET_DENSITIES * 10;
+    for(uint32_t col = 0; col < SHEET_COLS; col++) {
+        uint8_t* cell = cells + col * KAL_FRAME_BYTES;
+        kal_render_frames(style, density, SHEET_SEED + row, sheet_offsets[col], 1, cell);
+    }
+    pool_send(data, cells, ROW_BYTES);
+}
+
+// Copy the cells of a row into place, MSB first as PBM expects
+static bool receive(PoolWorker* w, const uint8_t* cells) {
+    for(uint32_t col = 0; col < SHEET_COLS; col++) {
+        const uint8_t* frame = cells + col * KAL_FRAME_BYTES;
+        for(uint8_t y = 0; y < KAL_HEIGHT; y++) {
+            uint32_t line = w->job * SHEET_CELL_H + SHEET_GAP + y;
+            uint8_t* out = &sheet[line * SHEET_STRIDE + (SHEET_GAP + col * SHEET_CELL_W) / 8];
+            kal_pack_reverse_row(&frame[y * KAL_STRIDE], out, KAL_STRIDE);
+        }
+    }
+    return true;
+}
+
+static void run(uint32_t jobs) {
+    sheet = malloc((size_t)SHEET_H * SHEET_STRIDE);
+    if(!sheet) pool_die("malloc");
+    memset(sheet, 0xFF, (size_t)SHEET_H * SHEET_STRIDE); // gap bars
+
+    PoolConfig config = {
+        .name = "kal_contact",
+        .workers = jobs,
+        .jobs = SHEET_ROWS,
+        .unit_bytes = ROW_BYTES,
+        .work = work,
+        .receive = receive,
+    };
+    pool_run(&config);
+
+    printf("P4\n%u %u\n", (unsigned)SHEET_W, (unsigned)SHEET_H);
+    fwrite(sheet, 1, (size_t)SHEET_H * SHEET_STRIDE, stdout);
+    fflush(stdout);
+    if(ferror(stdout)) pool_die("stdout");
+}
+
+//--------------------------------------------------------------------------------
+// Command line
+//--------------------------------------------------------------------------------
+static void usage(void) {
+    fprintf(
+        stderr,
+        "usage: kal_contact [-j workers] > contact_sheet.pbm\n"
+        "  -j  worker processes (default: one per core)\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    uint32_t jobs = pool_default_workers();
+    char* end;
+    int opt;
+    while((opt = getopt(argc, argv, "j:")) != -1) {
+        switch(opt) {
+            case 'j': jobs = pool_parse_number(optarg, &end, POOL_MAX_WORKERS, usage); break;
+            default: usage();
+        }
+        if(*end) usage();
+    }
+    if(optind != argc || jobs == 0) usage();
+
+    run(jobs);
+    return 0;
+}
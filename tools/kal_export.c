@@ -0,0 +1,261 @@
+//--------------------------------------------------------------------------------
+// kal_export: render clips of kaleidoscope frames on every core and write them,
+// strictly in order, to stdout as a stream of PBM images (or raw XBM frames)
+//
+//   kal_export [-j workers] [-n frames] [-b buffer] [-r] style[:density[:seed]]...
+//   kal_export -n 600 4:50 6:80:7 12 | ffmpeg -f image2pipe -c:v pbm -i - out.mp4
+//
+// The unit of work is a range of frames of one clip. Styles that can seek
+// (kal_seekable) render any frame from the frame number alone, so their
+// clips are cut into ranges that spread over the workers (see kal_pool.h);
+// the frames of the other styles build on each other (they simulate), so
+// each of their clips is a single range. A worker renders its ranges in
+// batches through kal_render_frames and streams the frames back. The parent
+// collects them in a reorder buffer of at most -b frames and writes them out
+// in order of their index in the whole export: frames of the range being
+// written pass straight through, workers ahead of it park theirs in the
+// buffer, and once it is full their pipes fill up and they block until the
+// writer catches up.
+//--------------------------------------------------------------------------------
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/kaleidoscope.h"
+#include "kal_pool.h"
+
+#define BATCH 16 // frames per kal_render_frames call
+#define RANGES_PER_WORKER 4 // ranges of seekable clips per worker, for balance
+
+typedef struct {
+    uint8_t style;
+    uint8_t density;
+    uint32_t seed;
+} Clip;
+
+typedef struct {
+    uint32_t clip;
+    uint32_t first_frame; // 1 for the first of the clip
+    uint32_t count;
+} Range;
+
+// Frames a worker has parked, oldest first (reorder buffer slots)
+typedef struct {
+    int32_t head;
+    int32_t tail;
+} Queue;
+
+static Clip* clips;
+static uint32_t clip_count;
+static uint32_t frames_per_clip = 300;
+static int raw = 0;
+
+static Range* ranges; // in output order
+static uint32_t range_count;
+
+static Queue queues[POOL_MAX_WORKERS];
+
+// Reorder buffer: slots are chained into each worker's queue or the free
+// list, and know the index of their frame in the whole export
+static uint8_t (*slot_frame)[KAL_FRAME_BYTES];
+static uint64_t* slot_index;
+static int32_t* slot_next;
+static int32_t free_slots = -1;
+static uint32_t free_count = 0;
+
+static int32_t* range_owner; // worker of each range, -1 until its first frame
+static uint32_t out_range = 0; // range being written
+static uint32_t out_frames = 0; // frames of it written so far
+static uint64_t out_index = 0; // index in the export of the next frame to write
+
+//--------------------------------------------------------------------------------
+// Worker: render a range
+//--------------------------------------------------------------------------------
+static void work(int32_t r, int data) {
+    static uint8_t batch[BATCH * KAL_FRAME_BYTES];
+    const Range* range = &ranges[r];
+    const Clip* c = &clips[range->clip];
+    for(uint32_t i = 0; i < range->count; i += BATCH) {
+        uint32_t n = range->count - i < BATCH ? range->count - i : BATCH;
+        kal_render_frames(c->style, c->density, c->seed, range->first_frame + i, n, batch);
+        pool_send(data, batch, n * KAL_FRAME_BYTES);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Output, strictly in clip and frame order
+//--------------------------------------------------------------------------------
+static void emit(const uint8_t* frame) {
+    if(!raw) {
+        uint8_t pbm[KAL_FRAME_BYTES];
+        kal_pack_reverse_row(frame, pbm, KAL_FRAME_BYTES);
+        printf("P4\n%u %u\n", KAL_WIDTH, KAL_HEIGHT);
+        fwrite(pbm, 1, sizeof(pbm), stdout);
+    } else {
+        fwrite(frame, 1, KAL_FRAME_BYTES, stdout);
+    }
+    if(ferror(stdout)) pool_die("stdout");
+    out_index++;
+    if(++out_frames == ranges[out_range].count) {
+        out_range++;
+        out_frames = 0;
+    }
+}
+
+// Write out whatever the buffer holds of the frames next in line
+static void drain(void) {
+    while(out_range < range_count && range_owner[out_range] >= 0) {
+        Queue* q = &queues[range_owner[out_range]];
+        int32_t s = q->head;
+        if(s < 0 || slot_index[s] != out_index) return;
+        emit(slot_frame[s]);
+        q->head = slot_next[s];
+        if(q->head < 0) q->tail = -1;
+        slot_next[s] = free_slots;
+        free_slots = s;
+        free_count++;
+    }
+}
+
+// Frames of the range being written skip the buffer once nothing is parked
+// ahead of them
+static bool passes_through(const PoolWorker* w) {
+    return w->job == (int32_t)out_range && queues[pool_index(w)].head < 0;
+}
+
+// A frame has somewhere to go when it passes through or a slot is free
+static bool ready(const PoolWorker* w) {
+    return passes_through(w) || free_count > 0;
+}
+
+static bool receive(PoolWorker* w, const uint8_t* frame) {
+    const Range* range = &ranges[w->job];
+    range_owner[w->job] = pool_index(w);
+    if(passes_through(w)) {
+        emit(frame);
+    } else {
+        Queue* q = &queues[pool_index(w)];
+        int32_t s = free_slots;
+        free_slots = slot_next[s];
+        free_count--;
+        memcpy(slot_frame[s], frame, KAL_FRAME_BYTES);
+        slot_index[s] = (uint64_t)range->clip * frames_per_clip + range->first_frame - 1 + w->units;
+        slot_next[s] = -1;
+        if(q->tail >= 0) slot_next[q->tail] = s;
+        else q->head = s;
+        q->tail = s;
+    }
+    return w->units + 1 == range->count;
+}
+
+// Cut the clips into ranges: seekable clips into pieces of about the same
+// length, so that every worker gets a few, the others whole
+static void split(uint32_t jobs) {
+    uint32_t seekable = 0;
+    for(uint32_t c = 0; c < clip_count; c++) seekable += kal_seekable(clips[c].style);
+    uint64_t total = (uint64_t)seekable * frames_per_clip;
+    uint64_t length = (total + jobs * RANGES_PER_WORKER - 1) / (jobs * RANGES_PER_WORKER);
+    length = (length + BATCH - 1) / BATCH * BATCH;
+    if(length < BATCH) length = BATCH;
+    if(length > frames_per_clip) length = frames_per_clip;
+
+    uint64_t count = clip_count - seekable;
+    if(seekable) count += seekable * ((frames_per_clip + length - 1) / length);
+    ranges = malloc(count * sizeof(*ranges));
+    range_owner = malloc(count * sizeof(*range_owner));
+    if(!ranges || !range_owner) pool_die("malloc");
+    range_count = 0;
+    for(uint32_t c = 0; c < clip_count; c++) {
+        uint32_t step = kal_seekable(clips[c].style) ? length : frames_per_clip;
+        for(uint32_t f = 0; f < frames_per_clip;) {
+            uint32_t n = frames_per_clip - f < step ? frames_per_clip - f : step;
+            range_owner[range_count] = -1;
+            ranges[range_count++] = (Range){c, f + 1, n};
+            f += n;
+        }
+    }
+}
+
+static void run(uint32_t jobs, uint32_t buffer) {
+    slot_frame = malloc((size_t)buffer * KAL_FRAME_BYTES);
+    slot_index = malloc(buffer * sizeof(*slot_index));
+    slot_next = malloc(buffer * sizeof(*slot_next));
+    if(!slot_frame || !slot_index || !slot_next) pool_die("malloc");
+    for(uint32_t s = 0; s < buffer; s++) {
+        slot_next[s] = free_slots;
+        free_slots = s;
+    }
+    free_count = buffer;
+    for(uint32_t i = 0; i < POOL_MAX_WORKERS; i++) queues[i] = (Queue){-1, -1};
+
+    split(jobs);
+    PoolConfig config = {
+        .name = "kal_export",
+        .workers = jobs,
+        .jobs = range_count,
+        .unit_bytes = KAL_FRAME_BYTES,
+        .work = work,
+        .ready = ready,
+        .receive = receive,
+        .round = drain,
+    };
+    pool_run(&config);
+    fflush(stdout);
+}
+
+//--------------------------------------------------------------------------------
+// Command line
+//--------------------------------------------------------------------------------
+static void usage(void) {
+    fprintf(
+        stderr,
+        "usage: kal_export [-j workers] [-n frames] [-b buffer] [-r] style[:density[:seed]]...\n"
+        "  -j  worker processes (default: one per core)\n"
+        "  -n  frames per clip (default 300)\n"
+        "  -b  reorder buffer size in frames (default 4096)\n"
+        "  -r  raw 1024-byte XBM frames instead of PBM images\n"
+        "  style 0..%u, density 0..%u (default 50), seed (default 1)\n",
+        KAL_STYLE_COUNT - 1,
+        KAL_DENSITY_MAX);
+    exit(2);
+}
+
+static Clip parse_clip(const char* arg) {
+    Clip c = {.density = 50, .seed = 1};
+    char* end;
+    c.style = pool_parse_number(arg, &end, KAL_STYLE_COUNT - 1, usage);
+    if(*end == ':') c.density = pool_parse_number(end + 1, &end, KAL_DENSITY_MAX, usage);
+    if(*end == ':') c.seed = pool_parse_number(end + 1, &end, UINT32_MAX, usage);
+    if(*end) usage();
+    return c;
+}
+
+int main(int argc, char** argv) {
+    uint32_t jobs = pool_default_workers();
+    uint32_t buffer = 4096;
+    char* end;
+    int opt;
+    while((opt = getopt(argc, argv, "j:n:b:r")) != -1) {
+        switch(opt) {
+            case 'j': jobs = pool_parse_number(optarg, &end, POOL_MAX_WORKERS, usage); break;
+            case 'n': frames_per_clip = pool_parse_number(optarg, &end, UINT32_MAX, usage); break;
+            case 'b': buffer = pool_parse_number(optarg, &end, 1 << 20, usage); break;
+            case 'r': raw = 1; break;
+            default: usage();
+        }
+        if(opt != 'r' && *end) usage();
+    }
+    if(optind == argc || jobs == 0 || frames_per_clip == 0 || buffer == 0) usage();
+
+    clip_count = argc - optind;
+    clips = malloc(clip_count * sizeof(*clips));
+    if(!clips) pool_die("malloc");
+    for(uint32_t c = 0; c < clip_count; c++) clips[c] = parse_clip(argv[optind + c]);
+
+    run(jobs, buffer);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "kal_pool.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/kaleidoscope.h"
+
+static PoolWorker workers[POOL_MAX_WORKERS];
+static uint32_t worker_count;
+static uint32_t next_job = 0; // next job to dispatch
+
+void pool_die(const char* what) {
+    perror(what);
+    exit(1);
+}
+
+static int read_all(int fd, void* buf, size_t n) {
+    uint8_t* p = buf;
+    while(n) {
+        ssize_t r = read(fd, p, n);
+        if(r < 0 && errno == EINTR) continue;
+        if(r <= 0) return -1;
+        p += r;
+        n -= r;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const void* buf, size_t n) {
+    const uint8_t* p = buf;
+    while(n) {
+        ssize_t r = write(fd, p, n);
+        if(r < 0 && errno == EINTR) continue;
+        if(r <= 0) return -1;
+        p += r;
+        n -= r;
+    }
+    return 0;
+}
+
+void pool_send(int data, const void* buf, size_t n) {
+    if(write_all(data, buf, n)) _exit(1);
+}
+
+uint32_t pool_index(const PoolWorker* w) {
+    return w - workers;
+}
+
+uint32_t pool_default_workers(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (uint32_t)cores : 1;
+}
+
+uint32_t pool_parse_number(const char* s, char** end, uint32_t max, void (*usage)(void)) {
+    errno = 0;
+    unsigned long v = strtoul(s, end, 0);
+    if(errno || *end == s || v > max) usage();
+    return v;
+}
+
+//--------------------------------------------------------------------------------
+// Worker process: run the jobs it is sent until told to quit
+//--------------------------------------------------------------------------------
+static void worker_main(const PoolConfig* config, int cmd, int data) {
+    void* arena = malloc(kal_arena_size());
+    if(!arena || !kal_init(arena, kal_arena_size())) _exit(1);
+
+    int32_t job;
+    while(read_all(cmd, &job, sizeof(job)) == 0 && job >= 0) config->work(job, data);
+    _exit(0);
+}
+
+static void worker_spawn(const PoolConfig* config, PoolWorker* w) {
+    int cmd[2], data[2];
+    if(pipe(cmd) || pipe(data)) pool_die("pipe");
+    fflush(stdout);
+    w->pid = fork();
+    if(w->pid < 0) pool_die("fork");
+    if(w->pid == 0) {
+        close(cmd[1]);
+        close(data[0]);
+        worker_main(config, cmd[0], data[1]);
+    }
+    close(cmd[0]);
+    close(data[1]);
+    w->cmd = cmd[1];
+    w->data = data[0];
+    w->job = -1;
+    w->unit = malloc(config->unit_bytes);
+    if(!w->unit) pool_die("malloc");
+}
+
+// Hand an idle worker the next job, if any are left
+static void worker_dispatch(const PoolConfig* config, PoolWorker* w) {
+    if(next_job >= config->jobs) return;
+    int32_t job = next_job++;
+    if(write_all(w->cmd, &job, sizeof(job))) pool_die("dispatch");
+    w->job = job;
+    w->units = 0;
+    w->partial = 0;
+}
+
+//--------------------------------------------------------------------------------
+// Parent
+//--------------------------------------------------------------------------------
+static bool worker_ready(const PoolConfig* config, const PoolWorker* w) {
+    return w->job >= 0 && (!config->ready || config->ready(w));
+}
+
+static void receive(const PoolConfig* config, PoolWorker* w) {
+    ssize_t r = read(w->data, w->unit + w->partial, config->unit_bytes - w->partial);
+    if(r < 0 && errno == EINTR) return;
+    if(r <= 0) {
+        fprintf(stderr, "%s: worker %u failed\n", config->name, (unsigned)pool_index(w));
+        exit(1);
+    }
+    w->partial += r;
+    if(w->partial < config->unit_bytes) return;
+    w->partial = 0;
+
+    bool last = config->receive(w, w->unit);
+    w->units++;
+    if(last) {
+        w->job = -1;
+        worker_dispatch(config, w);
+    }
+}
+
+void pool_run(const PoolConfig* config) {
+    worker_count = config->workers < config->jobs ? config->workers : config->jobs;
+    for(uint32_t i = 0; i < worker_count; i++) {
+        worker_spawn(config, &workers[i]);
+        worker_dispatch(config, &workers[i]);
+    }
+
+    struct pollfd fds[POOL_MAX_WORKERS];
+    PoolWorker* polled[POOL_MAX_WORKERS];
+    for(;;) {
+        nfds_t busy = 0, n = 0;
+        for(uint32_t i = 0; i < worker_count; i++) {
+            PoolWorker* w = &workers[i];
+            busy += w->job >= 0;
+            if(!worker_ready(config, w)) continue;
+            fds[n].fd = w->data;
+            fds[n].events = POLLIN;
+            polled[n++] = w;
+        }
+        if(!busy) break;
+        if(poll(fds, n, -1) < 0) {
+            if(errno == EINTR) continue;
+            pool_die("poll");
+        }
+        for(nfds_t i = 0; i < n; i++) {
+            // Reading may have used up what made the others ready
+            if(fds[i].revents && worker_ready(config, polled[i])) receive(config, polled[i]);
+        }
+        if(config->round) config->round();
+    }
+
+    int32_t quit = -1;
+    for(uint32_t i = 0; i < worker_count; i++) {
+        write_all(workers[i].cmd, &quit, sizeof(quit));
+        close(workers[i].cmd);
+        close(workers[i].data);
+        waitpid(workers[i].pid, NULL, 0);
+        free(workers[i].unit);
+    }
+}
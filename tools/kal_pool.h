@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------------
+// kal_pool: the worker processes behind the host tools
+//
+// Workers are processes because the engine keeps its state in module statics:
+// each one gets its own copy of the engine (and its own arena) and renders
+// the jobs it is handed, numbered 0 .. jobs - 1 and dispatched in that order,
+// writing their results to the parent over a pipe in units of a fixed size.
+// The parent polls the busy workers and hands every unit it reads to the
+// tool, which says when a job is complete; the worker then gets the next one.
+//--------------------------------------------------------------------------------
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define POOL_MAX_WORKERS 64
+
+typedef struct {
+    pid_t pid;
+    int cmd; // parent → worker: job index, -1 to quit
+    int data; // worker → parent: units
+    int32_t job; // job being read, -1 when idle
+    uint32_t units; // whole units of it read so far
+    uint32_t partial; // bytes of the next one read so far
+    uint8_t* unit;
+} PoolWorker;
+
+typedef struct {
+    const char* name; // for messages
+    uint32_t workers; // at most POOL_MAX_WORKERS, fewer when there are fewer jobs
+    uint32_t jobs;
+    size_t unit_bytes;
+
+    // In the worker: render job and send its units with pool_send
+    void (*work)(int32_t job, int data);
+    // In the parent: whether a unit of w may be read now; NULL for always.
+    // Workers that are not ready are held back by their pipes.
+    bool (*ready)(const PoolWorker* w);
+    // In the parent: take a unit of w->job (w->units before it were read
+    // already) and return true if it was the job's last
+    bool (*receive)(PoolWorker* w, const uint8_t* unit);
+    // In the parent: called after every round of reads; may be NULL
+    void (*round)(void);
+} PoolConfig;
+
+// Run every job of config, then stop the workers
+void pool_run(const PoolConfig* config);
+
+// Index of a worker, 0 .. config->workers - 1
+uint32_t pool_index(const PoolWorker* w);
+
+// Send n bytes to the parent from a worker; quits the worker on failure
+void pool_send(int data, const void* buf, size_t n);
+
+// One worker per core
+uint32_t pool_default_workers(void);
+
+// Print the failed call with its error and exit with status 1
+void pool_die(const char* what);
+
+// Parse a number up to max at s, leaving *end after it, or call usage (which
+// does not return) if there is none
+uint32_t pool_parse_number(const char* s, char** end, uint32_t max, void (*usage)(void));